@@ -0,0 +1,140 @@
+/**============================================================================
+Name        : trust_store.hpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Process-wide X509 trust store, built once and shared by the client contexts
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_TRUST_STORE_HPP
+#define BOOSTPROJECTS_TRUST_STORE_HPP
+
+#include <boost/asio/ssl.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <atomic>
+#include <mutex>
+
+#include "root_certificates.hpp"
+
+/*
+    load_root_certificates() parses the whole PEM bundle of root_certificates.hpp into every context.
+    The store below is parsed once, on first use, and each context takes a reference to it
+    (SSL_CTX_set1_cert_store): a new ssl::context costs a reference count instead of a few hundred
+    certificate decodes.
+
+    The store is shared: certificates added to one context afterwards (add_certificate_authority,
+    load_verify_file) show up in all of them.
+*/
+
+namespace trust_store
+{
+    namespace ssl = boost::asio::ssl;
+
+    enum sources : unsigned
+    {
+        // The bundle of root_certificates.hpp
+        builtin = 1u << 0,
+        // OpenSSL's default CA file and directory (SSL_CERT_FILE / SSL_CERT_DIR override them)
+        system = 1u << 1
+    };
+
+    namespace detail
+    {
+        inline std::atomic<unsigned>& configured_sources()
+        {
+            static std::atomic<unsigned> value { builtin };
+            return value;
+        }
+
+        inline std::atomic<bool>& built()
+        {
+            static std::atomic<bool> value { false };
+            return value;
+        }
+
+        struct store_holder
+        {
+            X509_STORE* store { nullptr };
+            boost::system::error_code error;
+
+            ~store_holder() {
+                X509_STORE_free(store);
+            }
+        };
+
+        inline const store_holder& build()
+        {
+            static store_holder holder;
+            static std::once_flag once;
+            std::call_once(once, [] {
+                built() = true;
+                const unsigned from = configured_sources().load();
+                // A scratch context does the PEM parsing of root_certificates.hpp, the store outlives it
+                ssl::context scratch { ssl::context::tls_client };
+                if (from & builtin) {
+                    load_root_certificates(scratch, holder.error);
+                    if (holder.error)
+                        return;
+                }
+                X509_STORE* const store = SSL_CTX_get_cert_store(scratch.native_handle());
+                if ((from & system) && 1 != X509_STORE_set_default_paths(store)) {
+                    holder.error = { static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category() };
+                    return;
+                }
+                X509_STORE_up_ref(store);
+                holder.store = store;
+            });
+            return holder;
+        }
+    }
+
+    // Where the shared store takes its certificates from. Returns false once the store is built.
+    inline bool set_sources(unsigned from) noexcept
+    {
+        if (detail::built())
+            return false;
+        detail::configured_sources() = from;
+        return true;
+    }
+
+    // Builds the shared store now rather than on the first connection, e.g. at startup
+    inline void warm_up(boost::system::error_code& ec)
+    {
+        ec = detail::build().error;
+    }
+
+    // Replaces the certificate store of `ctx` with the shared one
+    inline void attach(ssl::context& ctx,
+                       boost::system::error_code& ec)
+    {
+        const detail::store_holder& holder = detail::build();
+        ec = holder.error;
+        if (!ec)
+            SSL_CTX_set1_cert_store(ctx.native_handle(), holder.store);
+    }
+
+    inline void attach(ssl::context& ctx)
+    {
+        boost::system::error_code ec;
+        attach(ctx, ec);
+        if (ec)
+            throw boost::system::system_error { ec };
+    }
+}
+
+// Drop-in for load_root_certificates(): same certificates, parsed once per process
+
+inline void load_shared_root_certificates(ssl::context& ctx,
+                                          boost::system::error_code& ec)
+{
+    trust_store::attach(ctx, ec);
+}
+
+inline void load_shared_root_certificates(ssl::context& ctx)
+{
+    trust_store::attach(ctx);
+}
+
+#endif //BOOSTPROJECTS_TRUST_STORE_HPP
@@ -32,7 +32,10 @@ Description : Client.cpp
 #include <source_location>
 
 #include "server_certificate.hpp"
-#include "root_certificates.hpp"
+#include "trust_store.hpp"
+#include "TlsSessionStore.h"
+#include "DnsCache.h"
+#include "FanOut.h"
 
 
 namespace
@@ -178,11 +181,14 @@ namespace HTTP_Client_Async
         beast::flat_buffer buffer;
         http::request<http::empty_body> request;
         http::response<http::string_body> response;
+        DnsCache::Cache* dns { nullptr };
+        DnsCache::EndpointsPtr endpoints;
 
     public:
         // Objects are constructed with a strand to ensure that handlers do not execute concurrently.
-        explicit session(asio::io_context& ioc):
-            resolver(asio::make_strand(ioc)), stream(asio::make_strand(ioc)) {
+        explicit session(asio::io_context& ioc,
+                         DnsCache::Cache* dns = nullptr):
+            resolver(asio::make_strand(ioc)), stream(asio::make_strand(ioc)), dns { dns } {
         }
 
         // Start the asynchronous operation
@@ -198,7 +204,13 @@ namespace HTTP_Client_Async
             request.set(http::field::host, host);
             request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
 
-            // Look up the domain name
+            // Look up the domain name: through the shared cache when there is one
+            if (dns) {
+                asio::co_spawn(resolver.get_executor(),
+                               dns->resolve(std::string(host), static_cast<uint16_t>(std::stoi(std::string(port)))),
+                               beast::bind_front_handler(&session::on_cached, shared_from_this()));
+                return;
+            }
             resolver.async_resolve(host,port,
                                    beast::bind_front_handler(&session::on_resolve,shared_from_this()));
         }
@@ -217,6 +229,23 @@ namespace HTTP_Client_Async
                                  beast::bind_front_handler(&session::on_connect, shared_from_this()));
         }
 
+        void on_cached(const std::exception_ptr& exc,
+                       DnsCache::EndpointsPtr cached)
+        {
+            if (exc) {
+                try {
+                    std::rethrow_exception(exc);
+                } catch (const boost::system::system_error& error) {
+                    return fail(error.code(), "resolve");
+                }
+            }
+            // Shared with the cache: kept alive until the connect completes
+            endpoints = std::move(cached);
+            stream.expires_after(std::chrono::seconds(30u));
+            stream.async_connect(*endpoints,
+                                 beast::bind_front_handler(&session::on_connect, shared_from_this()));
+        }
+
         void on_connect(const beast::error_code& errorCode,
                         const tcp::resolver::results_type::endpoint_type&)
         {
@@ -282,8 +311,10 @@ namespace HTTP_Client_Async
         // The io_context is required for all I/O
         asio::io_context ioc;
 
+        DnsCache::Cache dns { ioc.get_executor(), DnsCache::systemLookup(ioc.get_executor()) };
+
         // Launch the asynchronous operation
-        std::make_shared<session>(ioc)->run(host, port, path, version);
+        std::make_shared<session>(ioc, &dns)->run(host, port, path, version);
 
         // Run the I/O service. The call will return when the get operation is complete.
         ioc.run();
@@ -365,10 +396,16 @@ namespace HTTPS_Client_Async
         beast::flat_buffer buffer;
         http::request<http::empty_body> request;
         http::response<http::string_body> response;
+        TlsSessionStore::Store* sessions { nullptr };
+        DnsCache::Cache* dns { nullptr };
+        DnsCache::EndpointsPtr endpoints;
 
     public:
         explicit Session(asio::any_io_executor ex,
-                         ssl::context& ctx): resolver_(ex), tcpStream { ex, ctx } {
+                         ssl::context& ctx,
+                         TlsSessionStore::Store* sessions = nullptr,
+                         DnsCache::Cache* dns = nullptr):
+            resolver_(ex), tcpStream { ex, ctx }, sessions { sessions }, dns { dns } {
         }
 
         // Start the asynchronous operation
@@ -385,6 +422,10 @@ namespace HTTPS_Client_Async
                 return;
             }
 
+            // Offer the session of the previous connection to this host, if there is one
+            if (sessions)
+                sessions->attach(tcpStream.native_handle(), std::string(host), static_cast<uint16_t>(port));
+
             // Set up an HTTP GET request message
             request.version(version);
             request.method(http::verb::get);
@@ -392,7 +433,12 @@ namespace HTTPS_Client_Async
             request.set(http::field::host, host);
             request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
 
-            // Look up the domain name
+            // Look up the domain name: through the shared cache when there is one
+            if (dns) {
+                asio::co_spawn(resolver_.get_executor(), dns->resolve(std::string(host), static_cast<uint16_t>(port)),
+                               beast::bind_front_handler(&Session::on_cached, shared_from_this()));
+                return;
+            }
             resolver_.async_resolve(host, std::to_string(port),
                                     beast::bind_front_handler(&Session::on_resolve, shared_from_this()));
         }
@@ -412,6 +458,24 @@ namespace HTTPS_Client_Async
                                    beast::bind_front_handler(&Session::on_connect,shared_from_this()));
         }
 
+        void on_cached(const std::exception_ptr& exc,
+                       DnsCache::EndpointsPtr cached)
+        {
+            if (exc) {
+                try {
+                    std::rethrow_exception(exc);
+                } catch (const boost::system::system_error& error) {
+                    return fail(error.code(), "resolve");
+                }
+            }
+            // Shared with the cache: kept alive until the connect completes
+            endpoints = std::move(cached);
+            beast::get_lowest_layer(tcpStream).expires_after(std::chrono::seconds(30U));
+            beast::get_lowest_layer(tcpStream)
+                    .async_connect(*endpoints,
+                                   beast::bind_front_handler(&Session::on_connect,shared_from_this()));
+        }
+
         void on_connect(const beast::error_code& errorCode,
                         const tcp::resolver::results_type::endpoint_type&)
         {
@@ -428,6 +492,9 @@ namespace HTTPS_Client_Async
             if (errorCode) {
                 return fail(errorCode, "handshake");
             }
+            if (sessions)
+                sessions->record(tcpStream.native_handle());
+
             // Set a timeout on the operation
             beast::get_lowest_layer(tcpStream).expires_after(std::chrono::seconds(30U));
 
@@ -509,19 +576,29 @@ namespace HTTPS_Client_Async
         ssl::context ctx{ssl::context::tlsv13_client};
 
         // This holds the root certificate used for verification
-        load_root_certificates(ctx);
+        load_shared_root_certificates(ctx);
 
         // Verify the remote server's certificate
         // ctx.set_verify_mode(ssl::verify_peer);
 
-        // Launch the asynchronous operation
-        // The session is constructed with a strand to
-        // ensure that handlers do not execute concurrently.
-        std::make_shared<Session>(asio::make_strand(ioc), ctx)->run(host, port, path, version);
+        // Sessions saved by the first connection are resumed by the second one
+        TlsSessionStore::Store sessions { ctx };
+        // Same for the name: the second connection doesn't resolve it again
+        DnsCache::Cache dns { ioc.get_executor(), DnsCache::systemLookup(ioc.get_executor()) };
 
-        // Run the I/O service. The call will return when
-        // the get operation is complete.
-        ioc.run();
+        for (int i = 0; i < 2; ++i)
+        {
+            // Launch the asynchronous operation
+            // The session is constructed with a strand to
+            // ensure that handlers do not execute concurrently.
+            std::make_shared<Session>(asio::make_strand(ioc), ctx, &sessions, &dns)->run(host, port, path, version);
+
+            // Run the I/O service. The call will return when
+            // the get operation is complete.
+            ioc.run();
+            ioc.restart();
+        }
+        std::cout << "TLS resumption rate: " << sessions.stats().resumptionRate() * 100 << "%\n";
     }
 }
 
@@ -534,7 +611,9 @@ namespace HTTPS_Awaitable
                                      int32_t port,
                                      std::string_view target,
                                      int32_t version,
-                                     ssl::context& ctx)
+                                     ssl::context& ctx,
+                                     TlsSessionStore::Store* sessions = nullptr,
+                                     DnsCache::Cache* dns = nullptr)
     {
         asio::any_io_executor executor = co_await asio::this_coro::executor;
         tcp::resolver resolver = asio::ip::tcp::resolver{ executor };
@@ -548,20 +627,32 @@ namespace HTTPS_Awaitable
                     asio::error::get_ssl_category());
         }
 
-        // Look up the domain name
-        auto const results = co_await resolver.async_resolve(host, std::to_string(port));
+        // Look up the domain name: through the shared cache when there is one
+        DnsCache::Endpoints endpoints;
+        if (dns) {
+            endpoints = *co_await dns->resolve(std::string(host), static_cast<uint16_t>(port));
+        } else {
+            for (const auto& result: co_await resolver.async_resolve(host, std::to_string(port)))
+                endpoints.push_back(result.endpoint());
+        }
 
         // Set the timeout.
         beast::get_lowest_layer(tcpStream).expires_after(std::chrono::seconds(30u));
 
         // Make the connection on the IP address we get from a lookup
-        co_await beast::get_lowest_layer(tcpStream).async_connect(results);
+        co_await beast::get_lowest_layer(tcpStream).async_connect(endpoints);
 
         // Set the timeout.
         beast::get_lowest_layer(tcpStream).expires_after(std::chrono::seconds(30u));
 
+        // Offer the session of the previous connection to this host: an abbreviated handshake, no certificate
+        if (sessions)
+            sessions->attach(tcpStream.native_handle(), std::string(host), static_cast<uint16_t>(port));
+
         // Perform the SSL handshake
         co_await tcpStream.async_handshake(ssl::stream_base::client);
+        if (sessions)
+            sessions->record(tcpStream.native_handle());
 
         // Set up an HTTP GET request message
         http::request<http::string_body> req{ http::verb::get, target, version };
@@ -612,10 +703,17 @@ namespace HTTPS_Awaitable
         ssl::context ctx { ssl::context::tlsv13_client };
 
         // This holds the root certificate used for verification
-        load_root_certificates(ctx);
+        load_shared_root_certificates(ctx);
 
-        // Launch the asynchronous operation
-        asio::co_spawn(ioCtx, do_session(host, port, path, version, ctx),[](std::exception_ptr e){
+        // TLS 1.3 tickets arrive after the handshake: they are saved while the response is read
+        TlsSessionStore::Store sessions { ctx };
+        DnsCache::Cache dns { ioCtx.get_executor(), DnsCache::systemLookup(ioCtx.get_executor()) };
+
+        // Launch the asynchronous operation: the second session resumes the first one, without a lookup
+        asio::co_spawn(ioCtx, [&]() -> asio::awaitable<void> {
+            co_await do_session(host, port, path, version, ctx, &sessions, &dns);
+            co_await do_session(host, port, path, version, ctx, &sessions, &dns);
+        },[](std::exception_ptr e){
             if (e) {
                 std::rethrow_exception(e);
             }
@@ -624,6 +722,38 @@ namespace HTTPS_Awaitable
         // Run the I/O service. The call will return when
         // the get operation is complete.
         ioCtx.run();
+        std::cout << "TLS resumption rate: " << sessions.stats().resumptionRate() * 100 << "%\n";
+    }
+
+    // Scatter-gather: several paths at once over pooled connections, each with its own deadline
+    void Send_Requests()
+    {
+        const FanOut::Origin origin { "127.0.0.1", 8443 };
+        const std::vector<std::string_view> targets { "/", "/index", "/status", "/missing" };
+
+        asio::io_context ioCtx;
+        ssl::context ctx { ssl::context::tlsv13_client };
+        load_shared_root_certificates(ctx);
+        ConnectionPool::Pool pool { ioCtx.get_executor(), ctx };
+
+        std::vector<FanOut::Call> calls;
+        for (const std::string_view target: targets)
+            calls.push_back(FanOut::Call { origin, FanOut::Request { http::verb::get, target, 11 } });
+
+        asio::co_spawn(ioCtx, [&]() -> asio::awaitable<void> {
+            const std::vector<FanOut::Result> results = co_await FanOut::all(pool, std::move(calls),
+                    FanOut::Options { .maxInFlight = 4, .deadline = std::chrono::seconds(1) });
+            for (const FanOut::Result& result: results) {
+                std::cout << targets[result.index] << ": " << (result.ok() ? std::to_string(result.response->result_int())
+                                                                           : result.error.message()) << std::endl;
+            }
+        }, [&](std::exception_ptr e) {
+            pool.close();
+            if (e) {
+                std::rethrow_exception(e);
+            }
+        });
+        ioCtx.run();
     }
 }
 
@@ -636,6 +766,7 @@ void Client::TestAll()
     // HTTP_Client_Async::Send_Request();
     // HTTPS_Client_Async::Send_Request();
     HTTPS_Awaitable::Send_Request();
+    // HTTPS_Awaitable::Send_Requests();
 
     // SSL_Clients::SSL_Request_Test();
 
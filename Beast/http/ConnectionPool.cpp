@@ -0,0 +1,465 @@
+/**============================================================================
+Name        : ConnectionPool.cpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Per-origin keep-alive pool of HTTPS client connections
+============================================================================**/
+
+#include "ConnectionPool.h"
+
+#include <iostream>
+#include <vector>
+#include <format>
+#include <print>
+#include <algorithm>
+#include <utility>
+#include <variant>
+#include <cerrno>
+#include <exception>
+
+#include <sys/socket.h>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/as_tuple.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/experimental/awaitable_operators.hpp>
+#include <boost/beast/version.hpp>
+
+#include "trust_store.hpp"
+
+namespace
+{
+    using namespace ConnectionPool;
+    using tcp = asio::ip::tcp;
+    using namespace asio::experimental::awaitable_operators;
+
+    // An idle HTTP connection has nothing to read. End of stream means the server closed it; data means a TLS alert
+    // or junk. Either way it can't carry the next request.
+    bool quiet(Connection& connection) noexcept
+    {
+        if (connection.buffer.size() > 0)
+            return false;
+
+        tcp::socket& socket = beast::get_lowest_layer(connection.stream).socket();
+        if (!socket.is_open())
+            return false;
+
+        char byte;
+        const ssize_t result = ::recv(socket.native_handle(), &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+        return result < 0 && (EAGAIN == errno || EWOULDBLOCK == errno);
+    }
+
+    // No TLS close_notify: the connection is dropped from the pool, nobody waits for the exchange
+    void discard(std::unique_ptr<Connection>& connection) noexcept
+    {
+        beast::error_code ignored;
+        beast::get_lowest_layer(connection->stream).socket().close(ignored);
+        connection.reset();
+    }
+}
+
+namespace ConnectionPool
+{
+    Lease::Lease(Pool& pool,
+                 std::unique_ptr<Connection> connection,
+                 bool wasIdle) noexcept
+        : pool { &pool }, connection { std::move(connection) }, wasIdle { wasIdle } {
+    }
+
+    Lease::Lease(Lease&& other) noexcept
+        : pool { std::exchange(other.pool, nullptr) }, connection { std::move(other.connection) },
+          wasIdle { other.wasIdle } {
+    }
+
+    Lease& Lease::operator=(Lease&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (connection)
+                pool->giveBack(std::move(connection), false);
+            pool = std::exchange(other.pool, nullptr);
+            connection = std::move(other.connection);
+            wasIdle = other.wasIdle;
+        }
+        return *this;
+    }
+
+    Lease::~Lease()
+    {
+        if (connection)
+            pool->giveBack(std::move(connection), false);
+    }
+
+    void Lease::release(bool keepAlive)
+    {
+        if (connection)
+            pool->giveBack(std::move(connection), keepAlive);
+    }
+
+    Pool::Pool(asio::any_io_executor executor,
+               ssl::context& ctx,
+               Options options)
+        : executor { std::move(executor) }, ctx { ctx }, options { options }, reaper { this->executor }
+    {
+        schedule();
+    }
+
+    Pool::~Pool()
+    {
+        close();
+    }
+
+    asio::awaitable<Lease> Pool::acquire(const Origin& origin)
+    {
+        const std::string key = origin.key();
+        const Clock::time_point deadline = Clock::now() + options.acquireTimeout;
+        while (true)
+        {
+            // Closed once the lock is released
+            std::vector<std::unique_ptr<Connection>> stale;
+            std::shared_ptr<Signal> signal;
+            {
+                std::lock_guard lock { mutex };
+                if (closed)
+                    throw boost::system::system_error(asio::error::operation_aborted, "acquire " + key);
+
+                Host& host = hosts[key];
+                const Clock::time_point now = Clock::now();
+                while (!host.idle.empty())
+                {
+                    std::unique_ptr<Connection> connection = std::move(host.idle.back());
+                    host.idle.pop_back();
+                    if (reusable(*connection, now) && quiet(*connection)) {
+                        ++reuses;
+                        co_return Lease { *this, std::move(connection), true };
+                    }
+                    ++unhealthy;
+                    --host.open;
+                    stale.push_back(std::move(connection));
+                }
+
+                if (host.open < options.maxPerHost) {
+                    // The slot is reserved for the new connection
+                    ++host.open;
+                    break;
+                }
+
+                signal = std::make_shared<Signal>(executor, 1);
+                host.waiters.push_back(signal);
+            }
+            for (std::unique_ptr<Connection>& connection: stale)
+                discard(connection);
+
+            ++waits;
+            asio::steady_timer timer { executor, deadline };
+            const auto woken = co_await (signal->async_receive(asio::as_tuple(asio::use_awaitable)) ||
+                                         timer.async_wait(asio::as_tuple(asio::use_awaitable)));
+            if (0 == woken.index())
+                continue;
+
+            ++timeouts;
+            {
+                std::lock_guard lock { mutex };
+                Host& host = hosts[key];
+                // Woken and timed out at once: the wakeup goes to the next waiter
+                if (0 == std::erase(host.waiters, signal))
+                    wakeOne(host);
+            }
+            throw boost::system::system_error(asio::error::timed_out, "acquire " + key);
+        }
+
+        try {
+            co_return Lease { *this, co_await connect(origin), false };
+        }
+        catch (...)
+        {
+            std::lock_guard lock { mutex };
+            Host& host = hosts[key];
+            --host.open;
+            wakeOne(host);
+            throw;
+        }
+    }
+
+    asio::awaitable<std::unique_ptr<Connection>> Pool::connect(const Origin& origin)
+    {
+        auto connection = std::make_unique<Connection>(executor, ctx, origin.key());
+        Stream& stream = connection->stream;
+
+        // Set SNI Hostname (many hosts need this to handshake successfully)
+        if (!SSL_set_tlsext_host_name(stream.native_handle(), origin.host.c_str()))
+        {
+            throw boost::system::system_error(
+                    static_cast<int>(::ERR_get_error()),
+                    asio::error::get_ssl_category());
+        }
+        // Used when the context verifies the peer
+        stream.set_verify_callback(ssl::host_name_verification(origin.host));
+
+        beast::get_lowest_layer(stream).expires_after(options.connectTimeout);
+        DnsCache::Endpoints endpoints;
+        if (options.resolver) {
+            endpoints = *co_await options.resolver->resolve(origin.host, origin.port);
+        } else {
+            tcp::resolver resolver { executor };
+            for (const auto& result: co_await resolver.async_resolve(origin.host, std::to_string(origin.port)))
+                endpoints.push_back(result.endpoint());
+        }
+
+        if (options.health) {
+            co_await HappyEyeballs::connect(beast::get_lowest_layer(stream).socket(), std::move(endpoints),
+                                            HappyEyeballs::Options { .timeout = options.connectTimeout,
+                                                                     .health = options.health });
+        } else {
+            co_await beast::get_lowest_layer(stream).async_connect(endpoints);
+        }
+        beast::get_lowest_layer(stream).socket().set_option(tcp::no_delay(true));
+        if (options.sessions)
+            options.sessions->attach(stream.native_handle(), origin.host, origin.port);
+        co_await stream.async_handshake(ssl::stream_base::client);
+        if (options.sessions)
+            options.sessions->record(stream.native_handle());
+        beast::get_lowest_layer(stream).expires_never();
+
+        ++connects;
+        co_return connection;
+    }
+
+    bool Pool::reusable(const Connection& connection,
+                        Clock::time_point now) const noexcept
+    {
+        return now - connection.created < options.maxLifetime
+               && now - connection.lastUsed < options.idleTimeout
+               && connection.requests < options.maxRequests;
+    }
+
+    void Pool::giveBack(std::unique_ptr<Connection> connection,
+                        bool keepAlive)
+    {
+        {
+            std::lock_guard lock { mutex };
+            Host& host = hosts[connection->key];
+            const Clock::time_point now = Clock::now();
+            if (keepAlive && !closed && reusable(*connection, now)) {
+                connection->lastUsed = now;
+                host.idle.push_back(std::move(connection));
+            } else {
+                --host.open;
+            }
+            wakeOne(host);
+        }
+        if (connection)
+            discard(connection);
+    }
+
+    void Pool::wakeOne(Host& host)
+    {
+        while (!host.waiters.empty())
+        {
+            const std::shared_ptr<Signal> signal = std::move(host.waiters.front());
+            host.waiters.pop_front();
+            if (signal->try_send(boost::system::error_code {}))
+                return;
+        }
+    }
+
+    void Pool::close()
+    {
+        std::vector<std::unique_ptr<Connection>> idle;
+        {
+            std::lock_guard lock { mutex };
+            closed = true;
+            for (auto& [key, host]: hosts)
+            {
+                host.open -= host.idle.size();
+                std::ranges::move(host.idle, std::back_inserter(idle));
+                host.idle.clear();
+                // They wake up, find the pool closed and throw
+                for (const std::shared_ptr<Signal>& signal: host.waiters)
+                    signal->try_send(boost::system::error_code {});
+                host.waiters.clear();
+            }
+        }
+        for (std::unique_ptr<Connection>& connection: idle)
+            discard(connection);
+        reaper.cancel();
+    }
+
+    void Pool::schedule()
+    {
+        reaper.expires_after(std::max<Clock::duration>(options.idleTimeout / 2, std::chrono::seconds(1)));
+        reaper.async_wait([this](const boost::system::error_code& errorCode) {
+            if (errorCode)
+                return;
+            reap();
+            schedule();
+        });
+    }
+
+    // Idle connections past their limits, or closed by the server, are dropped without waiting for acquire()
+    void Pool::reap()
+    {
+        std::vector<std::unique_ptr<Connection>> stale;
+        {
+            std::lock_guard lock { mutex };
+            const Clock::time_point now = Clock::now();
+            for (auto& [key, host]: hosts)
+            {
+                const size_t before = stale.size();
+                std::erase_if(host.idle, [&](std::unique_ptr<Connection>& connection) {
+                    if (reusable(*connection, now) && quiet(*connection))
+                        return false;
+                    stale.push_back(std::move(connection));
+                    return true;
+                });
+                host.open -= stale.size() - before;
+                for (size_t i = before; i < stale.size(); ++i)
+                    wakeOne(host);
+            }
+            std::erase_if(hosts, [](const auto& entry) {
+                return 0 == entry.second.open && entry.second.waiters.empty();
+            });
+        }
+        expired += stale.size();
+        for (std::unique_ptr<Connection>& connection: stale)
+            discard(connection);
+    }
+
+    Stats Pool::stats() const noexcept
+    {
+        return Stats {
+            .connects = connects.load(),
+            .reuses = reuses.load(),
+            .waits = waits.load(),
+            .timeouts = timeouts.load(),
+            .unhealthy = unhealthy.load(),
+            .expired = expired.load()
+        };
+    }
+
+    asio::awaitable<Response> send(Pool& pool,
+                                   const Origin& origin,
+                                   Request request)
+    {
+        request.set(http::field::host, origin.host);
+        if (!request.has(http::field::user_agent))
+            request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+        request.keep_alive(true);
+        request.prepare_payload();
+
+        for (int attempt = 0;; ++attempt)
+        {
+            Lease lease = co_await pool.acquire(origin);
+            Connection& connection = *lease;
+
+            beast::get_lowest_layer(connection.stream).expires_after(std::chrono::seconds(30u));
+            const auto [writeError, bytesWritten] = co_await http::async_write(connection.stream, request,
+                                                                               asio::as_tuple);
+            Response response;
+            beast::error_code readError;
+            if (!writeError) {
+                const auto [errorCode, bytesRead] = co_await http::async_read(connection.stream, connection.buffer,
+                                                                              response, asio::as_tuple);
+                readError = errorCode;
+            }
+
+            if (const beast::error_code errorCode = writeError ? writeError : readError)
+            {
+                // The server may close an idle connection between the health check and the write
+                const bool closedMeanwhile = writeError || http::error::end_of_stream == readError
+                                             || asio::error::connection_reset == readError;
+                if (lease.reused() && 0 == attempt && closedMeanwhile && idempotent(request.method()))
+                    continue;
+                throw boost::system::system_error(errorCode, "send " + origin.key());
+            }
+
+            beast::get_lowest_layer(connection.stream).expires_never();
+            ++connection.requests;
+            lease.release(response.keep_alive());
+            co_return response;
+        }
+    }
+
+    bool idempotent(http::verb method) noexcept
+    {
+        switch (method)
+        {
+            case http::verb::get:
+            case http::verb::head:
+            case http::verb::options:
+            case http::verb::put:
+            case http::verb::delete_:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    boost::system::error_code errorOf(const std::exception_ptr& exc)
+    {
+        if (!exc)
+            return {};
+        try {
+            std::rethrow_exception(exc);
+        }
+        catch (const boost::system::system_error& error) {
+            return error.code();
+        }
+        catch (...) {
+            return boost::system::errc::make_error_code(boost::system::errc::io_error);
+        }
+    }
+}
+
+// HTTPS_Server on 8443: concurrent workers share a few connections instead of connecting per request
+void ConnectionPool::TestAll()
+{
+    constexpr size_t workers { 32 };
+    constexpr size_t requestsPerWorker { 20 };
+
+    asio::io_context ioCtx;
+    ssl::context ctx { ssl::context::tlsv13_client };
+    load_shared_root_certificates(ctx);
+
+    DnsCache::Cache dns { ioCtx.get_executor(), DnsCache::systemLookup(ioCtx.get_executor()) };
+    TlsSessionStore::Store sessions { ctx };
+    HappyEyeballs::Health health;
+    Pool pool { ioCtx.get_executor(), ctx, Options { .maxPerHost = 4, .resolver = &dns, .sessions = &sessions,
+                                                     .health = &health } };
+    const Origin origin { "127.0.0.1", 8443 };
+
+    size_t done = 0;
+    const Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < workers; ++i)
+    {
+        asio::co_spawn(ioCtx, [&]() -> asio::awaitable<void> {
+            for (size_t n = 0; n < requestsPerWorker; ++n) {
+                const Response response = co_await send(pool, origin, Request { http::verb::get, "/", 11 });
+                boost::ignore_unused(response);
+            }
+        }, [&](std::exception_ptr e) {
+            if (e) {
+                try {
+                    std::rethrow_exception(e);
+                } catch (const std::exception& exc) {
+                    std::cerr << "Error: " << exc.what() << std::endl;
+                }
+            }
+            // Stops the idle reaper, so that run() returns
+            if (workers == ++done)
+                pool.close();
+        });
+    }
+    ioCtx.run();
+
+    const auto elapsed = std::chrono::duration<double>(Clock::now() - start);
+    const Stats stats = pool.stats();
+    std::println("{} requests in {:.3f} s: {} connects, {} reuses, {} waits, {} timeouts, {} unhealthy, {} expired",
+                 workers * requestsPerWorker, elapsed.count(), stats.connects, stats.reuses, stats.waits,
+                 stats.timeouts, stats.unhealthy, stats.expired);
+    std::println("TLS resumption rate: {:.1f}%", sessions.stats().resumptionRate() * 100);
+}
@@ -0,0 +1,230 @@
+/**============================================================================
+Name        : ConnectionPool.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Per-origin keep-alive pool of HTTPS client connections
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_CONNECTIONPOOL_H
+#define BOOSTPROJECTS_CONNECTIONPOOL_H
+
+#include <string>
+#include <deque>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <exception>
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include "DnsCache.h"
+#include "TlsSessionStore.h"
+#include "HappyEyeballs.h"
+
+namespace ConnectionPool
+{
+    namespace asio = boost::asio;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    namespace ssl = asio::ssl;
+
+    using Clock = std::chrono::steady_clock;
+    using Stream = ssl::stream<beast::tcp_stream>;
+    using Request = http::request<http::string_body>;
+    using Response = http::response<http::string_body>;
+
+    struct Origin
+    {
+        std::string host;
+        uint16_t port { 443 };
+
+        [[nodiscard]]
+        std::string key() const {
+            return host + ':' + std::to_string(port);
+        }
+    };
+
+    struct Options
+    {
+        // Connections open to one origin, idle and in use
+        size_t maxPerHost { 8 };
+        // How long acquire() waits for a connection when the origin is at its limit
+        Clock::duration acquireTimeout { std::chrono::seconds(10) };
+        Clock::duration connectTimeout { std::chrono::seconds(10) };
+        // Idle connections are closed after that: servers drop them on their own keep-alive timeout anyway
+        Clock::duration idleTimeout { std::chrono::seconds(30) };
+        Clock::duration maxLifetime { std::chrono::minutes(5) };
+        uint32_t maxRequests { 1000 };
+        // Shared DNS cache: without it, every new connection resolves the host
+        DnsCache::Cache* resolver { nullptr };
+        // Resumes TLS sessions of earlier connections; must be the store installed on the pool's ssl::context
+        TlsSessionStore::Store* sessions { nullptr };
+        // Set: endpoints are raced with staggered starts, healthy fast ones first. Otherwise tried in order.
+        HappyEyeballs::Health* health { nullptr };
+    };
+
+    struct Stats
+    {
+        uint64_t connects { 0 };
+        uint64_t reuses { 0 };
+        uint64_t waits { 0 };
+        uint64_t timeouts { 0 };
+        // Idle connections found closed by the server, or with unexpected data, when taken from the pool
+        uint64_t unhealthy { 0 };
+        uint64_t expired { 0 };
+    };
+
+    struct Connection
+    {
+        Stream stream;
+        std::string key;
+        // Bytes read past a response stay with the connection
+        beast::flat_buffer buffer;
+        Clock::time_point created { Clock::now() };
+        Clock::time_point lastUsed { Clock::now() };
+        uint32_t requests { 0 };
+
+        Connection(const asio::any_io_executor& executor,
+                   ssl::context& ctx,
+                   std::string key): stream { executor, ctx }, key { std::move(key) } {
+        }
+    };
+
+    class Pool;
+
+    // Exclusive use of one connection. release() hands it back for reuse after a complete keep-alive exchange;
+    // a lease destroyed without release() closes the connection, whose state is unknown.
+    class Lease
+    {
+        Pool* pool { nullptr };
+        std::unique_ptr<Connection> connection;
+        bool wasIdle { false };
+
+    public:
+        Lease() = default;
+        Lease(Pool& pool,
+              std::unique_ptr<Connection> connection,
+              bool wasIdle) noexcept;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        ~Lease();
+
+        [[nodiscard]]
+        Connection& operator*() const noexcept {
+            return *connection;
+        }
+
+        [[nodiscard]]
+        Connection* operator->() const noexcept {
+            return connection.get();
+        }
+
+        // Taken from the idle list: a failure before any response byte may be the server closing it meanwhile
+        [[nodiscard]]
+        bool reused() const noexcept {
+            return wasIdle;
+        }
+
+        void release(bool keepAlive);
+    };
+
+    class Pool
+    {
+        using Signal = asio::experimental::concurrent_channel<void(boost::system::error_code)>;
+
+        struct Host
+        {
+            // Most recently used at the back: reused first, while its TCP and TLS state is warm
+            std::deque<std::unique_ptr<Connection>> idle;
+            size_t open { 0 };
+            // acquire() calls waiting for a free slot, woken in order
+            std::deque<std::shared_ptr<Signal>> waiters;
+        };
+
+        asio::any_io_executor executor;
+        ssl::context& ctx;
+        const Options options;
+
+        std::mutex mutex;
+        std::unordered_map<std::string, Host> hosts;
+        asio::steady_timer reaper;
+        bool closed { false };
+
+        std::atomic<uint64_t> connects { 0 };
+        std::atomic<uint64_t> reuses { 0 };
+        std::atomic<uint64_t> waits { 0 };
+        std::atomic<uint64_t> timeouts { 0 };
+        std::atomic<uint64_t> unhealthy { 0 };
+        std::atomic<uint64_t> expired { 0 };
+
+        friend Lease;
+
+    public:
+        Pool(asio::any_io_executor executor,
+             ssl::context& ctx,
+             Options options = {});
+
+        ~Pool();
+
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        // An idle connection to `origin` when a healthy one is left, a new one while under the limit,
+        // otherwise the first one released (throws asio::error::timed_out after acquireTimeout)
+        asio::awaitable<Lease> acquire(const Origin& origin);
+
+        // Closes the idle connections and stops the idle reaper. Leases still out are closed on release.
+        void close();
+
+        [[nodiscard]]
+        Stats stats() const noexcept;
+
+        [[nodiscard]]
+        const Options& settings() const noexcept {
+            return options;
+        }
+
+    private:
+        asio::awaitable<std::unique_ptr<Connection>> connect(const Origin& origin);
+
+        [[nodiscard]]
+        bool reusable(const Connection& connection,
+                      Clock::time_point now) const noexcept;
+
+        void giveBack(std::unique_ptr<Connection> connection,
+                      bool keepAlive);
+
+        void wakeOne(Host& host);
+
+        void schedule();
+        void reap();
+    };
+
+    // Sends `request` on a pooled connection and reads the response. A reused connection that fails
+    // before the response arrives is replaced by a new one, once.
+    asio::awaitable<Response> send(Pool& pool,
+                                   const Origin& origin,
+                                   Request request);
+
+    // Safe to send again when the first attempt may have reached the server
+    [[nodiscard]]
+    bool idempotent(http::verb method) noexcept;
+
+    // Code of the system_error in `exc`, io_error for any other exception, none without one
+    [[nodiscard]]
+    boost::system::error_code errorOf(const std::exception_ptr& exc);
+
+    void TestAll();
+}
+
+#endif //BOOSTPROJECTS_CONNECTIONPOOL_H
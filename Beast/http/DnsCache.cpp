@@ -0,0 +1,301 @@
+/**============================================================================
+Name        : DnsCache.cpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Shared asynchronous DNS cache: TTLs, negative caching, coalescing and refresh-ahead
+============================================================================**/
+
+#include "DnsCache.h"
+
+#include <iostream>
+#include <format>
+#include <print>
+#include <string>
+#include <algorithm>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/as_tuple.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/system/system_error.hpp>
+#include <boost/core/ignore_unused.hpp>
+
+namespace
+{
+    using namespace DnsCache;
+
+    // Stands for a DNS server in tests: a hosts table answered after a fixed latency, with a query counter
+    Lookup hostsTable(asio::any_io_executor executor,
+                      std::unordered_map<std::string, std::string> hosts,
+                      Clock::duration latency,
+                      std::atomic<uint64_t>& queries)
+    {
+        return [executor, hosts = std::move(hosts), latency, &queries](std::string host,
+                                                                       std::string service) -> asio::awaitable<Endpoints> {
+            ++queries;
+            asio::steady_timer timer { executor, latency };
+            co_await timer.async_wait();
+
+            const auto iter = hosts.find(host);
+            if (hosts.end() == iter)
+                throw boost::system::system_error(asio::error::host_not_found, host);
+            co_return Endpoints { tcp::endpoint { asio::ip::make_address(iter->second),
+                                                  static_cast<uint16_t>(std::stoi(service)) } };
+        };
+    }
+}
+
+namespace DnsCache
+{
+    Lookup systemLookup(asio::any_io_executor executor)
+    {
+        return [executor](std::string host, std::string service) -> asio::awaitable<Endpoints> {
+            tcp::resolver resolver { executor };
+            const tcp::resolver::results_type results = co_await resolver.async_resolve(host, service);
+
+            Endpoints endpoints;
+            endpoints.reserve(results.size());
+            for (const auto& result: results)
+                endpoints.push_back(result.endpoint());
+            co_return endpoints;
+        };
+    }
+
+    Cache::Cache(asio::any_io_executor executor,
+                 Lookup lookup,
+                 Options options)
+        : executor { std::move(executor) }, lookup { std::move(lookup) }, options { options } {
+    }
+
+    asio::awaitable<EndpointsPtr> Cache::resolve(std::string host,
+                                                 uint16_t port)
+    {
+        const std::string key = std::format("{}:{}", host, port);
+        bool waited = false;
+        while (true)
+        {
+            EndpointsPtr endpoints;
+            std::shared_ptr<Signal> signal;
+            bool refresh = false;
+            {
+                std::lock_guard lock { mutex };
+                const Clock::time_point now = Clock::now();
+                auto iter = entries.find(key);
+                const bool fresh = entries.end() != iter && now < iter->second.expires
+                                   && (iter->second.endpoints || iter->second.error);
+                if (fresh)
+                {
+                    Entry& entry = iter->second;
+                    if (entry.error) {
+                        ++negativeHits;
+                        throw boost::system::system_error(entry.error, "resolve " + key);
+                    }
+                    if (!waited)
+                        ++hits;
+
+                    const auto refreshAt = entry.fetched + std::chrono::duration_cast<Clock::duration>(
+                            (entry.expires - entry.fetched) * options.refreshAhead);
+                    if (!entry.pending && now >= refreshAt) {
+                        entry.pending = true;
+                        refresh = true;
+                    }
+                    endpoints = entry.endpoints;
+                }
+                else
+                {
+                    if (entries.end() == iter) {
+                        if (entries.size() >= options.maxEntries)
+                            makeRoom(now);
+                        iter = entries.emplace(key, Entry {}).first;
+                    }
+
+                    Entry& entry = iter->second;
+                    if (entry.pending) {
+                        // Someone is already looking the name up
+                        signal = std::make_shared<Signal>(executor, 1);
+                        entry.waiters.push_back(signal);
+                        if (!waited)
+                            ++coalesced;
+                    } else {
+                        entry.pending = true;
+                        if (!waited)
+                            ++misses;
+                    }
+                }
+            }
+
+            if (endpoints)
+            {
+                if (refresh)
+                {
+                    // The request path gets the cached endpoints now, the refreshed ones come with the next call
+                    ++refreshes;
+                    asio::co_spawn(executor, fetch(key, host, std::to_string(port)), asio::detached);
+                }
+                co_return endpoints;
+            }
+
+            if (!signal)
+            {
+                const auto [result, error] = co_await fetch(key, host, std::to_string(port));
+                if (error)
+                    throw boost::system::system_error(error, "resolve " + key);
+                co_return result;
+            }
+
+            co_await signal->async_receive(asio::as_tuple(asio::use_awaitable));
+            waited = true;
+        }
+    }
+
+    asio::awaitable<Cache::Result> Cache::fetch(std::string key,
+                                                std::string host,
+                                                std::string service)
+    {
+        ++lookups;
+        EndpointsPtr endpoints;
+        boost::system::error_code error;
+        try
+        {
+            endpoints = std::make_shared<const Endpoints>(co_await lookup(std::move(host), std::move(service)));
+            if (endpoints->empty())
+                error = asio::error::host_not_found;
+        }
+        catch (const boost::system::system_error& exc) {
+            error = exc.code();
+        }
+        catch (const std::exception&) {
+            // The entry must not stay pending: its waiters would never wake up
+            error = boost::system::errc::make_error_code(boost::system::errc::io_error);
+        }
+
+        std::lock_guard lock { mutex };
+        Entry& entry = entries[key];
+        const Clock::time_point now = Clock::now();
+        if (!error)
+        {
+            entry.endpoints = endpoints;
+            entry.error = {};
+            entry.fetched = now;
+            entry.expires = now + options.ttl;
+        }
+        else if (!entry.endpoints || now >= entry.expires)
+        {
+            entry.endpoints.reset();
+            entry.error = error;
+            entry.fetched = now;
+            entry.expires = now + options.negativeTtl;
+        }
+        // Otherwise a failed refresh leaves the endpoints in use until they expire
+
+        entry.pending = false;
+        for (const std::shared_ptr<Signal>& waiter: entry.waiters)
+            waiter->try_send(boost::system::error_code {});
+        entry.waiters.clear();
+        co_return Result { error ? nullptr : endpoints, error };
+    }
+
+    void Cache::invalidate(std::string_view host,
+                           uint16_t port)
+    {
+        std::lock_guard lock { mutex };
+        if (const auto iter = entries.find(std::format("{}:{}", host, port)); entries.end() != iter) {
+            if (!iter->second.pending)
+                entries.erase(iter);
+        }
+    }
+
+    void Cache::makeRoom(Clock::time_point now)
+    {
+        std::erase_if(entries, [now](const auto& item) {
+            return !item.second.pending && now >= item.second.expires;
+        });
+        if (entries.size() < options.maxEntries)
+            return;
+
+        // All fresh: an eighth of the cache goes at once, so the next misses don't sort it again
+        std::vector<std::pair<Clock::time_point, const std::string*>> oldest;
+        oldest.reserve(entries.size());
+        for (const auto& [key, entry]: entries) {
+            if (!entry.pending)
+                oldest.emplace_back(entry.fetched, &key);
+        }
+        const size_t count = std::min(oldest.size(), entries.size() - options.maxEntries * 7 / 8);
+        std::ranges::nth_element(oldest, oldest.begin() + static_cast<std::ptrdiff_t>(count));
+        for (size_t i = 0; i < count; ++i)
+            entries.erase(*oldest[i].second);
+    }
+
+    Stats Cache::stats() const noexcept
+    {
+        return Stats {
+            .hits = hits.load(),
+            .negativeHits = negativeHits.load(),
+            .misses = misses.load(),
+            .coalesced = coalesced.load(),
+            .refreshes = refreshes.load(),
+            .lookups = lookups.load()
+        };
+    }
+}
+
+void DnsCache::TestAll()
+{
+    using namespace std::chrono_literals;
+    constexpr auto latency = 50ms;
+
+    asio::io_context ioCtx;
+    std::atomic<uint64_t> queries { 0 };
+    Cache cache { ioCtx.get_executor(),
+                  hostsTable(ioCtx.get_executor(), { { "api.local", "10.0.0.1" }, { "db.local", "10.0.0.2" } },
+                             latency, queries),
+                  Options { .ttl = 400ms, .negativeTtl = 200ms, .refreshAhead = 0.5 } };
+
+    const auto report = [&](std::string_view step) {
+        const Stats stats = cache.stats();
+        std::println("{:<32} queries {}, hits {}, misses {}, coalesced {}, negative {}, refreshes {}", step,
+                     queries.load(), stats.hits, stats.misses, stats.coalesced, stats.negativeHits, stats.refreshes);
+    };
+
+    // 100 concurrent requests for a cold name: one query
+    for (int i = 0; i < 100; ++i)
+        asio::co_spawn(ioCtx, cache.resolve("api.local", 443), asio::detached);
+    ioCtx.run();
+    report("100 concurrent cold lookups");
+
+    ioCtx.restart();
+    asio::co_spawn(ioCtx, [&]() -> asio::awaitable<void> {
+        asio::steady_timer timer { co_await asio::this_coro::executor };
+        const auto timed = [&](std::string_view host) -> asio::awaitable<Clock::duration> {
+            const Clock::time_point start = Clock::now();
+            const auto [exc, endpoints] = co_await asio::co_spawn(co_await asio::this_coro::executor,
+                    cache.resolve(std::string { host }, 443), asio::as_tuple(asio::use_awaitable));
+            boost::ignore_unused(exc, endpoints);
+            co_return Clock::now() - start;
+        };
+
+        // Unknown name: the second failure comes from the negative entry
+        co_await timed("missing.local");
+        co_await timed("missing.local");
+        report("unknown name twice");
+
+        // Past half the TTL: answered from the cache, refreshed in the background
+        timer.expires_after(250ms);
+        co_await timer.async_wait();
+        const Clock::duration refreshAhead = co_await timed("api.local");
+        timer.expires_after(2 * latency);
+        co_await timer.async_wait();
+        report(std::format("refresh-ahead hit in {} us", refreshAhead / 1us));
+
+        // Nobody asked for the name during its TTL: the next request waits for the resolver
+        timer.expires_after(500ms);
+        co_await timer.async_wait();
+        const Clock::duration expired = co_await timed("api.local");
+        report(std::format("expired lookup in {} us", expired / 1us));
+    }, asio::detached);
+    ioCtx.run();
+}
@@ -0,0 +1,127 @@
+/**============================================================================
+Name        : DnsCache.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Shared asynchronous DNS cache: TTLs, negative caching, coalescing and refresh-ahead
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_DNSCACHE_H
+#define BOOSTPROJECTS_DNSCACHE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <utility>
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
+#include <boost/system/error_code.hpp>
+
+namespace DnsCache
+{
+    namespace asio = boost::asio;
+    using tcp = asio::ip::tcp;
+    using Clock = std::chrono::steady_clock;
+
+    using Endpoints = std::vector<tcp::endpoint>;
+    using EndpointsPtr = std::shared_ptr<const Endpoints>;
+
+    // The actual lookup: throws boost::system::system_error when the name can't be resolved
+    using Lookup = std::function<asio::awaitable<Endpoints>(std::string host, std::string service)>;
+
+    // getaddrinfo through tcp::resolver. It reports no TTL: entries live for Options::ttl.
+    Lookup systemLookup(asio::any_io_executor executor);
+
+    struct Options
+    {
+        Clock::duration ttl { std::chrono::seconds(60) };
+        // Failed lookups are remembered that long, so a bad name doesn't send every request to the resolver
+        Clock::duration negativeTtl { std::chrono::seconds(5) };
+        // Past this fraction of its TTL, a hit returns the cached endpoints and refreshes them in the background
+        double refreshAhead { 0.75 };
+        size_t maxEntries { 4096 };
+    };
+
+    struct Stats
+    {
+        uint64_t hits { 0 };
+        uint64_t negativeHits { 0 };
+        uint64_t misses { 0 };
+        uint64_t coalesced { 0 };
+        uint64_t refreshes { 0 };
+        uint64_t lookups { 0 };
+    };
+
+    class Cache
+    {
+        using Signal = asio::experimental::concurrent_channel<void(boost::system::error_code)>;
+        using Result = std::pair<EndpointsPtr, boost::system::error_code>;
+
+        struct Entry
+        {
+            EndpointsPtr endpoints;
+            // Set for a negative entry
+            boost::system::error_code error;
+            Clock::time_point fetched;
+            Clock::time_point expires;
+            // A lookup is running: misses wait for it, hits don't start another refresh
+            bool pending { false };
+            std::vector<std::shared_ptr<Signal>> waiters;
+        };
+
+        asio::any_io_executor executor;
+        Lookup lookup;
+        const Options options;
+
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+
+        std::atomic<uint64_t> hits { 0 };
+        std::atomic<uint64_t> negativeHits { 0 };
+        std::atomic<uint64_t> misses { 0 };
+        std::atomic<uint64_t> coalesced { 0 };
+        std::atomic<uint64_t> refreshes { 0 };
+        std::atomic<uint64_t> lookups { 0 };
+
+    public:
+        // Background refreshes run on `executor`
+        Cache(asio::any_io_executor executor,
+              Lookup lookup,
+              Options options = {});
+
+        // Cached endpoints of host:port. Concurrent misses for one name share a single lookup.
+        // Throws the lookup error, also while it is cached as a negative entry.
+        asio::awaitable<EndpointsPtr> resolve(std::string host,
+                                              uint16_t port);
+
+        // Drops the entry, e.g. after every endpoint refused the connection
+        void invalidate(std::string_view host,
+                        uint16_t port);
+
+        [[nodiscard]]
+        Stats stats() const noexcept;
+
+    private:
+        // Runs the lookup of an entry marked pending, stores the result and wakes the waiters
+        asio::awaitable<Result> fetch(std::string key,
+                                      std::string host,
+                                      std::string service);
+
+        // Drops the expired entries, then the least recently fetched ones while the cache is still full
+        void makeRoom(Clock::time_point now);
+    };
+
+    void TestAll();
+}
+
+#endif //BOOSTPROJECTS_DNSCACHE_H
@@ -0,0 +1,180 @@
+/**============================================================================
+Name        : FanOut.cpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Concurrent request fan-out over pooled HTTPS connections
+============================================================================**/
+
+#include "FanOut.h"
+
+#include <iostream>
+#include <format>
+#include <print>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/deferred.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/experimental/parallel_group.hpp>
+#include <boost/system/system_error.hpp>
+
+#include "trust_store.hpp"
+
+namespace
+{
+    using namespace FanOut;
+    namespace http = boost::beast::http;
+    namespace ssl = asio::ssl;
+
+    struct Batch
+    {
+        std::vector<Call> calls;
+        OnResult onResult;
+        Options options;
+        // Next call to send: workers take them in order
+        std::atomic<size_t> next { 0 };
+        std::mutex mutex;
+    };
+
+    // The request races its deadline: the timer winning cancels the send, whose connection is then closed
+    asio::awaitable<Result> sendOne(ConnectionPool::Pool& pool,
+                                    Call& call,
+                                    Clock::duration deadline)
+    {
+        const asio::any_io_executor executor = co_await asio::this_coro::executor;
+        const Clock::time_point start = Clock::now();
+        asio::steady_timer timer { executor, deadline };
+
+        auto [order, exc, response, timerError] = co_await asio::experimental::make_parallel_group(
+                asio::co_spawn(executor, ConnectionPool::send(pool, call.origin, std::move(call.request)),
+                               asio::deferred),
+                timer.async_wait(asio::deferred)
+        ).async_wait(asio::experimental::wait_for_one(), asio::use_awaitable);
+
+        Result result { .elapsed = Clock::now() - start };
+        if (1 == order[0])
+            result.error = asio::error::timed_out;
+        else if (exc)
+            result.error = ConnectionPool::errorOf(exc);
+        else
+            result.response = std::move(response);
+        co_return result;
+    }
+
+    asio::awaitable<void> worker(ConnectionPool::Pool& pool,
+                                 Batch& batch)
+    {
+        for (size_t index = batch.next++; index < batch.calls.size(); index = batch.next++)
+        {
+            Call& call = batch.calls[index];
+            Result result = co_await sendOne(pool, call, Clock::duration::zero() == call.deadline
+                                                         ? batch.options.deadline : call.deadline);
+            result.index = index;
+
+            std::lock_guard lock { batch.mutex };
+            batch.onResult(std::move(result));
+        }
+    }
+}
+
+namespace FanOut
+{
+    asio::awaitable<void> each(ConnectionPool::Pool& pool,
+                               std::vector<Call> calls,
+                               OnResult onResult,
+                               Options options)
+    {
+        const asio::any_io_executor executor = co_await asio::this_coro::executor;
+        Batch batch { .calls = std::move(calls), .onResult = std::move(onResult), .options = options };
+
+        // A fixed set of workers bounds the requests in flight without a semaphore
+        const size_t workers = std::min(std::max<size_t>(options.maxInFlight, 1), batch.calls.size());
+        using Operation = decltype(asio::co_spawn(executor, worker(pool, batch), asio::deferred));
+        std::vector<Operation> operations;
+        operations.reserve(workers);
+        for (size_t i = 0; i < workers; ++i)
+            operations.push_back(asio::co_spawn(executor, worker(pool, batch), asio::deferred));
+        if (operations.empty())
+            co_return;
+
+        auto [order, exceptions] = co_await asio::experimental::make_parallel_group(std::move(operations))
+                .async_wait(asio::experimental::wait_for_all(), asio::use_awaitable);
+
+        // Only the callback can throw
+        for (const std::exception_ptr& exc: exceptions) {
+            if (exc)
+                std::rethrow_exception(exc);
+        }
+    }
+
+    asio::awaitable<std::vector<Result>> all(ConnectionPool::Pool& pool,
+                                             std::vector<Call> calls,
+                                             Options options)
+    {
+        std::vector<Result> results(calls.size());
+        co_await each(pool, std::move(calls), [&results](Result&& result) {
+            results[result.index] = std::move(result);
+        }, options);
+        co_return results;
+    }
+}
+
+// HTTPS_Server on 8443: 200 requests, 16 at a time over 8 pooled connections
+void FanOut::TestAll()
+{
+    using namespace std::chrono_literals;
+    constexpr size_t requests { 200 };
+
+    asio::io_context ioCtx;
+    ssl::context ctx { ssl::context::tlsv13_client };
+    load_shared_root_certificates(ctx);
+    ConnectionPool::Pool pool { ioCtx.get_executor(), ctx, ConnectionPool::Options { .maxPerHost = 8 } };
+
+    const auto batch = [] {
+        std::vector<Call> calls;
+        for (size_t i = 0; i < requests; ++i)
+            calls.push_back(Call { Origin { "127.0.0.1", 8443 }, Request { http::verb::get, "/", 11 } });
+        // Too short to make it: reported as timed out, the others are not held up
+        calls.front().deadline = 1us;
+        return calls;
+    };
+
+    asio::co_spawn(ioCtx, [&]() -> asio::awaitable<void> {
+        const Options options { .maxInFlight = 16, .deadline = 500ms };
+
+        // As completed: the first answers are usable before the slowest one arrives
+        size_t completed = 0;
+        const Clock::time_point start = Clock::now();
+        co_await each(pool, batch(), [&](Result&& result) {
+            if (0 == completed++ || requests == completed)
+                std::println("#{} done after {} us: {}", completed, (Clock::now() - start) / 1us,
+                             result.ok() ? std::to_string(result.response->result_int()) : result.error.message());
+        }, options);
+
+        // In order
+        const std::vector<Result> results = co_await all(pool, batch(), options);
+        std::vector<Clock::duration> latencies;
+        size_t failed = 0;
+        for (const Result& result: results) {
+            if (result.ok())
+                latencies.push_back(result.elapsed);
+            else
+                ++failed;
+        }
+        std::ranges::sort(latencies);
+        if (!latencies.empty())
+            std::println("{} ok, {} failed; p50 {} us, p99 {} us", latencies.size(), failed,
+                         latencies[latencies.size() / 2] / 1us, latencies[latencies.size() * 99 / 100] / 1us);
+    }, [&](const std::exception_ptr& exc) {
+        pool.close();
+        if (exc)
+            std::rethrow_exception(exc);
+    });
+    ioCtx.run();
+}
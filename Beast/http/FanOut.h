@@ -0,0 +1,81 @@
+/**============================================================================
+Name        : FanOut.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Concurrent request fan-out over pooled HTTPS connections
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_FANOUT_H
+#define BOOSTPROJECTS_FANOUT_H
+
+#include <vector>
+#include <optional>
+#include <functional>
+#include <chrono>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/system/error_code.hpp>
+
+#include "ConnectionPool.h"
+
+namespace FanOut
+{
+    namespace asio = boost::asio;
+
+    using Clock = std::chrono::steady_clock;
+    using ConnectionPool::Origin;
+    using ConnectionPool::Request;
+    using ConnectionPool::Response;
+
+    struct Call
+    {
+        Origin origin;
+        Request request;
+        // Zero: Options::deadline
+        Clock::duration deadline { Clock::duration::zero() };
+    };
+
+    struct Result
+    {
+        // Position of the call in the batch
+        size_t index { 0 };
+        std::optional<Response> response;
+        // asio::error::timed_out when the deadline came first
+        boost::system::error_code error;
+        Clock::duration elapsed { Clock::duration::zero() };
+
+        [[nodiscard]]
+        bool ok() const noexcept {
+            return response.has_value();
+        }
+    };
+
+    struct Options
+    {
+        // Requests of the batch sent at the same time; the rest wait for a free slot
+        size_t maxInFlight { 16 };
+        // Counted from the moment the request leaves the queue, connection wait included
+        Clock::duration deadline { std::chrono::seconds(2) };
+    };
+
+    // Called once per call, in completion order. Calls are serialized, also on a multithreaded executor.
+    using OnResult = std::function<void(Result&&)>;
+
+    // Runs the calls concurrently and reports each one as soon as it completes.
+    // Cancelling the awaiting coroutine cancels the requests still running.
+    asio::awaitable<void> each(ConnectionPool::Pool& pool,
+                               std::vector<Call> calls,
+                               OnResult onResult,
+                               Options options = {});
+
+    // Same, with the results in the order of the calls once the whole batch is done
+    asio::awaitable<std::vector<Result>> all(ConnectionPool::Pool& pool,
+                                             std::vector<Call> calls,
+                                             Options options = {});
+
+    void TestAll();
+}
+
+#endif //BOOSTPROJECTS_FANOUT_H
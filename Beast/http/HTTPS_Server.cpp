@@ -14,20 +14,32 @@ Description : HTTPS_Server.cpp
 #include <array>
 #include <source_location>
 #include <thread>
+#include <filesystem>
+#include <format>
+#include <deque>
+#include <optional>
+#include <algorithm>
+#include <unordered_map>
 
 #include <boost/config.hpp>
 #include <boost/asio.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ssl.hpp>
 #include <boost/asio/ssl/stream.hpp>
+#include <boost/asio/stream_file.hpp>
+#include <boost/asio/thread_pool.hpp>
 
 #include <boost/beast.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/beast/version.hpp>
 
+#include <openssl/evp.h>
+
 #include "server_certificate.hpp"
 #include "root_certificates.hpp"
+#include "ResponseCache.h"
+#include "RequestHandler.h"
 
 
 namespace
@@ -84,52 +96,6 @@ namespace
         return "application/text";
     }
 
-    constexpr std::string_view mimeType(beast::string_view path) {
-        if (path.ends_with(".htm"sv))
-            return "text/html";
-        if (path.ends_with(".html"sv))
-            return "text/html";
-        if (path.ends_with(".php"sv))
-            return "text/html";
-        if (path.ends_with(".css"sv))
-            return "text/css";
-        if (path.ends_with(".txt"sv))
-            return "text/plain";
-        if (path.ends_with(".js"sv))
-            return "application/javascript";
-        if (path.ends_with(".json"sv))
-            return "application/json";
-        if (path.ends_with(".xml"sv))
-            return "application/xml";
-        if (path.ends_with(".swf"sv))
-            return "application/x-shockwave-flash";
-        if (path.ends_with(".flv"sv))
-            return "video/x-flv";
-        if (path.ends_with(".png"sv))
-            return "image/png";
-        if (path.ends_with(".jpe"sv))
-            return "image/jpeg";
-        if (path.ends_with(".jpeg"sv))
-            return "image/jpeg";
-        if (path.ends_with(".jpg"sv))
-            return "image/jpeg";
-        if (path.ends_with(".gif"sv))
-            return "image/gif";
-        if (path.ends_with(".bmp"sv))
-            return "image/bmp";
-        if (path.ends_with(".ico"sv))
-            return "image/vnd.microsoft.icon";
-        if (path.ends_with(".tiff"sv))
-            return "image/tiff";
-        if (path.ends_with(".tif"sv))
-            return "image/tiff";
-        if (path.ends_with(".svg"sv))
-            return "image/svg+xml";
-        if (path.ends_with(".svgz"sv))
-            return "image/svg+xml";
-        return "application/text";
-    }
-
     void fail(const beast::error_code &errorCode,
               char const *what) {
         if (errorCode == asio::ssl::error::stream_truncated)
@@ -137,111 +103,7 @@ namespace
         std::cerr << what << ": " << errorCode.message() << "\n";
     }
 
-    // Append an HTTP rel-path to a local filesystem path -> returned path is normalized for the platform.
-    std::string path_cat(std::string_view base,
-                         std::string_view path) {
-        if (base.empty())
-            return std::string(path);
-        std::string result(base);
-
-        constexpr char path_separator = '/';
-        if (result.back() == path_separator)
-            result.resize(result.size() - 1);
-        result.append(path.data(), path.size());
-        return result;
-    }
-
-    // Return a response for the given request.
-    // The concrete type of the response message (which depends on the request), is type-erased in message_generator.
-    template <class Body, class Allocator>
-    http::message_generator handle_request(std::string_view doc_root,
-                                           http::request<Body, http::basic_fields<Allocator>>&& request)
-    {
-        // Returns a bad request response
-        const auto bad_request = [&request](beast::string_view why) {
-            http::response<http::string_body> response { http::status::bad_request, request.version() };
-            response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-            response.set(http::field::content_type, "text/html");
-            response.keep_alive(request.keep_alive());
-            response.body() = std::string(why);
-            response.prepare_payload();
-            return response;
-        };
-
-        // Returns a not found response
-        const auto not_found = [&request](beast::string_view target) {
-            http::response<http::string_body> response { http::status::not_found, request.version() };
-            response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-            response.set(http::field::content_type, "text/html");
-            response.keep_alive(request.keep_alive());
-            response.body() = "The resource '" + std::string(target) + "' was not found.";
-            response.prepare_payload();
-            return response;
-        };
-
-        // Returns a server error response
-        const auto server_error = [&request](beast::string_view what) {
-            http::response<http::string_body> response { http::status::internal_server_error, request.version() };
-            response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-            response.set(http::field::content_type, "text/html");
-            response.keep_alive(request.keep_alive());
-            response.body() = "An error occurred: '" + std::string(what) + "'";
-            response.prepare_payload();
-            return response;
-        };
-
-        // Make sure we can handle the method
-        if (http::verb::get != request.method() && http::verb::head != request.method())
-            return bad_request("Unknown HTTP-method");
-
-        // Request path must be absolute and not contain "..".
-        if (request.target().empty() || request.target()[0] != '/' || request.target().find("..") != beast::string_view::npos)
-            return bad_request("Illegal request-target");
-
-        // Build the path to the requested file
-        std::string path = path_cat(doc_root, request.target());
-        if ('/' == request.target().back())
-            path.append("index.html");
-
-        // Attempt to open the file
-        beast::error_code errorCode;
-        http::file_body::value_type body;
-        body.open(path.c_str(), beast::file_mode::scan, errorCode);
-
-        // Handle the case where the file doesn't exist
-        if (beast::errc::no_such_file_or_directory == errorCode)
-            return not_found(request.target());
-
-        // Handle an unknown error
-        if (errorCode) {
-            return server_error(errorCode.message());
-        }
-
-        // Cache the size since we need it after the move
-        const uint16_t size = body.size();
-
-        // Respond to HEAD request
-        if (request.method() == http::verb::head)
-        {
-            http::response<http::empty_body> res{http::status::ok, request.version()};
-            res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-            res.set(http::field::content_type, mimeType(path));
-            res.content_length(size);
-            res.keep_alive(request.keep_alive());
-            return res;
-        }
-
-        // Respond to GET request
-        http::response<http::file_body> response { std::piecewise_construct,
-                                                   std::make_tuple(std::move(body)),
-                                                   std::make_tuple(http::status::ok, request.version())
-        };
-        response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        response.set(http::field::content_type, mimeType(path));
-        response.content_length(size);
-        response.keep_alive(request.keep_alive());
-        return response;
-    }
+    using RequestHandler::handle_request;
 }
 
 
@@ -337,19 +199,277 @@ namespace HTTPS_Server_Sync
 
 namespace HTTPS_Server_ASync
 {
+    // Requests with this target prefix are streamed to disk instead of being buffered in memory
+    constexpr std::string_view uploadTarget { "/upload/" };
+    constexpr std::string_view uploadDir { "/tmp/uploads" };
+
+    // Per-request body limits: regular requests are small, uploads may be multi-GB
+    constexpr uint64_t requestBodyLimit { 1024 * 1024 };
+    constexpr uint64_t uploadBodyLimit { 16ULL * 1024 * 1024 * 1024 };
+
+    // Dynamic handlers: their responses are served through the response cache
+    constexpr std::string_view apiTarget { "/api/" };
+
+    // Memory used by one upload is chunkCount * chunkSize, whatever the size of the body
+    constexpr size_t chunkSize { 64 * 1024 };
+    constexpr size_t chunkCount { 4 };
+
+#if defined(BOOST_ASIO_HAS_FILE)
+    // Backed by io_uring on Linux (BOOST_ASIO_HAS_IO_URING)
+    using UploadFile = asio::stream_file;
+#else
+    // Blocking fallback when Asio is built without file support
+    using UploadFile = beast::file;
+#endif
+
+    // SHA-256 of an upload, updated chunk by chunk on the hashing thread pool
+    class Sha256
+    {
+        std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx { EVP_MD_CTX_new(), &EVP_MD_CTX_free };
+
+    public:
+        Sha256() {
+            EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr);
+        }
+
+        void update(const char* data, size_t size) {
+            EVP_DigestUpdate(ctx.get(), data, size);
+        }
+
+        [[nodiscard]]
+        std::string hexDigest()
+        {
+            std::array<unsigned char, EVP_MAX_MD_SIZE> digest {};
+            unsigned int length = 0;
+            EVP_DigestFinal_ex(ctx.get(), digest.data(), &length);
+
+            std::string hex;
+            hex.reserve(length * 2);
+            for (unsigned int i = 0; i < length; ++i)
+                std::format_to(std::back_inserter(hex), "{:02x}", digest[i]);
+            return hex;
+        }
+    };
+
+    http::message_generator status_response(http::status status,
+                                            unsigned version,
+                                            bool keep_alive,
+                                            std::string body)
+    {
+        http::response<http::string_body> response { status, version };
+        response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        response.set(http::field::content_type, "text/html");
+        response.keep_alive(keep_alive);
+        response.body() = std::move(body);
+        response.prepare_payload();
+        return response;
+    }
+
+    struct Route
+    {
+        std::string prefix;
+        std::string docRoot;
+
+        // The prefix stands for docRoot itself: "/images/logo.png" of the "/images/" route is "/logo.png"
+        [[nodiscard]]
+        std::string localTarget(beast::string_view target) const
+        {
+            const size_t length = prefix.ends_with('/') ? prefix.size() - 1 : prefix.size();
+            const std::string_view local { target.substr(length) };
+            return local.starts_with('/') ? std::string { local } : std::format("/{}", local);
+        }
+    };
+
+    // A domain served by this process: its own certificate, routing table and cache of dynamic responses
+    struct VirtualHost
+    {
+        std::string name;
+        ssl::context context { ssl::context::tlsv13 };
+        // Sorted by descending prefix length, so the first match is the longest one
+        std::vector<Route> routes;
+        // Per host: the same target on two domains is two different resources
+        std::unique_ptr<ResponseCache::Cache> responseCache;
+
+        [[nodiscard]]
+        const Route* routeFor(beast::string_view target) const noexcept
+        {
+            for (const Route& route: routes) {
+                if (target.starts_with(route.prefix))
+                    return &route;
+            }
+            return nullptr;
+        }
+    };
+
+    // Transparent hash: the servername callback looks names up without allocating
+    struct StringHash
+    {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view value) const noexcept {
+            return std::hash<std::string_view> {}(value);
+        }
+    };
+
+    // SNI-driven selection among pre-built ssl::context objects behind one listener
+    class VirtualHosts
+    {
+        std::unordered_map<std::string, std::unique_ptr<VirtualHost>, StringHash, std::equal_to<>> hosts;
+        VirtualHost* defaultHost { nullptr };
+        // Dynamic responses of every host are computed there
+        asio::any_io_executor apiExecutor;
+
+        // Selects the certificate of the requested host in the middle of the handshake
+        static int on_servername(SSL* ssl,
+                                 [[maybe_unused]] int* alert,
+                                 void* arg)
+        {
+            const auto* self = static_cast<const VirtualHosts*>(arg);
+            const char* serverName = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+            const VirtualHost* host = self->find(serverName ? serverName : "");
+            if (host != self->defaultHost)
+                SSL_set_SSL_CTX(ssl, const_cast<ssl::context&>(host->context).native_handle());
+            return SSL_TLSEXT_ERR_OK;
+        }
+
+    public:
+
+        explicit VirtualHosts(asio::any_io_executor apiExecutor): apiExecutor { std::move(apiExecutor) } {
+        }
+
+        // Without certificate files the host uses the built-in test certificate
+        VirtualHost& add(std::string_view name,
+                         std::vector<Route> routes,
+                         const std::string& certificateChainFile = {},
+                         const std::string& privateKeyFile = {})
+        {
+            auto host = std::make_unique<VirtualHost>();
+            host->name.resize(name.size());
+            std::ranges::transform(name, host->name.begin(), [](unsigned char c) { return std::tolower(c); });
+
+            if (certificateChainFile.empty()) {
+                load_server_certificate(host->context);
+            } else {
+                host->context.use_certificate_chain_file(certificateChainFile);
+                host->context.use_private_key_file(privateKeyFile, ssl::context::file_format::pem);
+            }
+
+            std::ranges::sort(routes, std::greater {}, [](const Route& route) { return route.prefix.size(); });
+            host->routes = std::move(routes);
+            host->responseCache = std::make_unique<ResponseCache::Cache>(apiExecutor,
+                    std::chrono::seconds(10U), std::chrono::seconds(60U));
+
+            // The first host is the default one: it answers clients without SNI or with an unknown name
+            if (nullptr == defaultHost)
+            {
+                defaultHost = host.get();
+                SSL_CTX_set_tlsext_servername_callback(defaultHost->context.native_handle(), &VirtualHosts::on_servername);
+                SSL_CTX_set_tlsext_servername_arg(defaultHost->context.native_handle(), this);
+            }
+
+            const std::string key = host->name;
+            return *hosts.insert_or_assign(key, std::move(host)).first->second;
+        }
+
+        // O(1): one lookup for the exact name, one for the "*.parent" wildcard
+        [[nodiscard]]
+        const VirtualHost* find(std::string_view serverName) const noexcept
+        {
+            std::array<char, 256> buffer {};
+            if (serverName.empty() || serverName.size() > buffer.size())
+                return defaultHost;
+
+            std::ranges::transform(serverName, buffer.begin(), [](unsigned char c) { return std::tolower(c); });
+            const std::string_view name { buffer.data(), serverName.size() };
+            if (const auto host = hosts.find(name); hosts.end() != host)
+                return host->second.get();
+
+            if (const size_t dot = name.find('.'); std::string_view::npos != dot && dot > 0)
+            {
+                // Reuse the byte before the dot for the '*' of the wildcard entry
+                buffer[dot - 1] = '*';
+                if (const auto host = hosts.find(name.substr(dot - 1)); hosts.end() != host)
+                    return host->second.get();
+            }
+            return defaultHost;
+        }
+
+        // Sessions are created with the default host context, the SNI callback switches it per connection
+        [[nodiscard]]
+        ssl::context& listenerContext() const
+        {
+            if (nullptr == defaultHost)
+                throw std::logic_error("No virtual hosts configured");
+            return defaultHost->context;
+        }
+    };
+
+    // Stands for an expensive dynamic handler (report generation, aggregation, ...)
+    ResponseCache::Response api_handler(const ResponseCache::Request& request)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250U));
+
+        ResponseCache::Response response { http::status::ok, request.version() };
+        response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        response.set(http::field::content_type, "application/json");
+        response.set(http::field::cache_control, "max-age=5, stale-while-revalidate=30");
+        response.set(http::field::vary, "Accept");
+        response.body() = std::format(R"({{"target":"{}","generated":{}}})", std::string_view { request.target() },
+                                      std::chrono::system_clock::now().time_since_epoch().count());
+        return response;
+    }
+
     class session : public std::enable_shared_from_this<session>
     {
+        struct Chunk
+        {
+            std::unique_ptr<char[]> data { std::make_unique<char[]>(chunkSize) };
+            size_t size { 0 };
+            // Outstanding consumers of the chunk: the file write and the hash update
+            uint32_t pending { 0 };
+        };
+
         ssl::stream<beast::tcp_stream> tcpStream;
         beast::flat_buffer buffer;
-        std::string_view docRoot;
-        http::request<http::string_body> request {};
+
+        // Chosen from the SNI name once the handshake is done
+        const VirtualHosts& virtualHosts;
+        const VirtualHost* virtualHost { nullptr };
+
+        // The header is read first, then the parser is converted to the body type the target needs
+        std::optional<http::request_parser<http::empty_body>> headerParser;
+        std::optional<http::request_parser<http::string_body>> requestParser;
+        std::optional<http::request_parser<http::buffer_body>> uploadParser;
+
+        // Cached response being written and the per-request header fields appended to it
+        ResponseCache::CachedResponsePtr cachedResponse;
+        std::string cachedFields;
+
+        // Upload state: chunks travel socket -> file and socket -> hash in parallel
+        asio::strand<asio::thread_pool::executor_type> hashStrand;
+        // Blocking writes of the beast::file fallback, kept off the I/O threads
+        asio::thread_pool::executor_type fileExecutor;
+        http::response<http::empty_body> continueResponse;
+        std::optional<UploadFile> file;
+        std::array<Chunk, chunkCount> chunks;
+        std::deque<size_t> writeQueue;
+        std::unique_ptr<Sha256> sha256;
+        std::string uploadPath;
+        uint64_t uploadSize { 0 };
+        bool reading { false };
+        bool writing { false };
+        bool aborted { false };
 
     public:
 
         // Take ownership of the socket
         explicit session(tcp::socket&& socket,
                          ssl::context& ctx,
-                         std::string_view doc_root) : tcpStream { std::move(socket), ctx } , docRoot { doc_root }{
+                         const VirtualHosts& hosts,
+                         asio::thread_pool& hashPool,
+                         asio::thread_pool& filePool) :
+                tcpStream { std::move(socket), ctx }, virtualHosts { hosts },
+                hashStrand { asio::make_strand(hashPool) }, fileExecutor { filePool.get_executor() } {
         }
 
         // Start the asynchronous operation
@@ -375,22 +495,30 @@ namespace HTTPS_Server_ASync
             if (ec) {
                 return fail(ec, "handshake");
             }
+
+            // The SNI callback has already switched the certificate: take the routing table of the same host
+            const char* serverName = SSL_get_servername(tcpStream.native_handle(), TLSEXT_NAMETYPE_host_name);
+            virtualHost = virtualHosts.find(serverName ? serverName : "");
             do_read();
         }
 
         void do_read()
         {
-            request.clear();
+            headerParser.emplace();
+            requestParser.reset();
+            uploadParser.reset();
+            cachedResponse.reset();
+
             // Set the timeout.
             beast::get_lowest_layer(tcpStream).expires_after(std::chrono::seconds(30u));
 
-            // Read a request
-            http::async_read(tcpStream, buffer, request,
-                             beast::bind_front_handler(&session::on_read,shared_from_this()));
+            // Read the request header only: the target decides where the body goes
+            http::async_read_header(tcpStream, buffer, *headerParser,
+                                    beast::bind_front_handler(&session::on_read_header, shared_from_this()));
         }
 
-        void on_read(const beast::error_code& errorCode,
-                     std::size_t bytes_transferred)
+        void on_read_header(const beast::error_code& errorCode,
+                            std::size_t bytes_transferred)
         {
             boost::ignore_unused(bytes_transferred);
 
@@ -398,11 +526,304 @@ namespace HTTPS_Server_ASync
             if (http::error::end_of_stream == errorCode) {
                 return do_close();
             }
+            if (errorCode) {
+                return fail(errorCode, "read_header");
+            }
+
+            const auto& header = headerParser->get();
+            if ((http::verb::put == header.method() || http::verb::post == header.method()) &&
+                header.target().starts_with(uploadTarget)) {
+                return start_upload();
+            }
+
+            // Everything else is small enough to be read into memory
+            requestParser.emplace(std::move(*headerParser));
+            requestParser->body_limit(requestBodyLimit);
+            http::async_read(tcpStream, buffer, *requestParser,
+                             beast::bind_front_handler(&session::on_read,shared_from_this()));
+        }
+
+        void on_read(const beast::error_code& errorCode,
+                     std::size_t bytes_transferred)
+        {
+            boost::ignore_unused(bytes_transferred);
+
+            if (http::error::body_limit == errorCode) {
+                return send_response(status_response(http::status::payload_too_large,
+                        requestParser->get().version(), false, "Request body is too large"));
+            }
             if (errorCode) {
                 return fail(errorCode, "read");
             }
+            if (requestParser->get().target().starts_with(apiTarget)) {
+                return serve_cached(requestParser->release());
+            }
+
+            const Route* route = virtualHost->routeFor(requestParser->get().target());
+            if (nullptr == route) {
+                return send_response(status_response(http::status::not_found, requestParser->get().version(),
+                        requestParser->get().keep_alive(), "No route for '" + std::string(requestParser->get().target()) + "'"));
+            }
+            http::request<http::string_body> request = requestParser->release();
+            request.target(route->localTarget(request.target()));
+
             // Send the response
-            send_response(handle_request(docRoot, std::move(request)));
+            send_response(handle_request(route->docRoot, std::move(request)));
+        }
+
+        void serve_cached(http::request<http::string_body>&& request)
+        {
+            const bool keep_alive = request.keep_alive();
+            const bool head_only = http::verb::head == request.method();
+
+            // The callback runs on a worker thread (or inline on a hit): hop back onto the session strand
+            virtualHost->responseCache->get(std::make_shared<const ResponseCache::Request>(std::move(request)), &api_handler,
+                    [self = shared_from_this(), keep_alive, head_only](ResponseCache::CachedResponsePtr response) {
+                asio::dispatch(self->tcpStream.get_executor(), [self, response = std::move(response), keep_alive, head_only] {
+                    self->send_cached(response, keep_alive, head_only);
+                });
+            });
+        }
+
+        void send_cached(ResponseCache::CachedResponsePtr response,
+                         bool keep_alive,
+                         bool head_only)
+        {
+            // The shared serialized response is written as is, only Age and Connection are per request
+            cachedResponse = std::move(response);
+            cachedFields = std::format("Age: {}\r\n{}\r\n", cachedResponse->age(ResponseCache::Clock::now()).count(),
+                                       keep_alive ? "" : "Connection: close\r\n");
+            const std::array<asio::const_buffer, 3> buffers {
+                asio::buffer(cachedResponse->head),
+                asio::buffer(cachedFields),
+                head_only ? asio::const_buffer {} : asio::buffer(cachedResponse->body)
+            };
+
+            beast::get_lowest_layer(tcpStream).expires_after(std::chrono::seconds(30u));
+            asio::async_write(tcpStream, buffers,
+                              beast::bind_front_handler(&session::on_write, shared_from_this(), keep_alive));
+        }
+
+        void start_upload()
+        {
+            const auto& header = headerParser->get();
+            const beast::string_view name = header.target().substr(uploadTarget.size());
+
+            // The connection is closed after a rejected upload: its body is still on the wire
+            if (name.empty() || name.find('/') != beast::string_view::npos || name.find("..") != beast::string_view::npos) {
+                return send_response(status_response(http::status::bad_request,
+                        header.version(), false, "Illegal upload name"));
+            }
+            if (headerParser->content_length().value_or(0) > uploadBodyLimit) {
+                return send_response(status_response(http::status::payload_too_large,
+                        header.version(), false, "Upload is too large"));
+            }
+
+            beast::error_code errorCode;
+            uploadPath = std::format("{}/{}", uploadDir, std::string_view { name });
+#if defined(BOOST_ASIO_HAS_FILE)
+            file.emplace(tcpStream.get_executor());
+            file->open(uploadPath, UploadFile::write_only | UploadFile::create | UploadFile::truncate, errorCode);
+#else
+            file.emplace();
+            file->open(uploadPath.c_str(), beast::file_mode::write, errorCode);
+#endif
+            if (errorCode) {
+                return send_response(status_response(http::status::internal_server_error,
+                        header.version(), false, "An error occurred: '" + errorCode.message() + "'"));
+            }
+
+            const bool expectContinue = beast::iequals(header[http::field::expect], "100-continue");
+            uploadParser.emplace(std::move(*headerParser));
+            uploadParser->body_limit(uploadBodyLimit);
+            sha256 = std::make_unique<Sha256>();
+            uploadSize = 0;
+            aborted = false;
+
+            if (!expectContinue) {
+                return read_chunk();
+            }
+
+            // The client waits for this before sending the body
+            continueResponse = http::response<http::empty_body> { http::status::continue_, uploadParser->get().version() };
+            http::async_write(tcpStream, continueResponse,
+                              beast::bind_front_handler(&session::on_continue, shared_from_this()));
+        }
+
+        void on_continue(const beast::error_code& errorCode,
+                         std::size_t bytes_transferred)
+        {
+            boost::ignore_unused(bytes_transferred);
+            if (errorCode) {
+                abort_upload();
+                return fail(errorCode, "write");
+            }
+            read_chunk();
+        }
+
+        void read_chunk()
+        {
+            const auto chunk = std::ranges::find_if(chunks, [](const Chunk& c) { return 0 == c.pending; });
+            if (chunks.end() == chunk) {
+                // Every chunk is still being written or hashed: stop reading the socket until one is released
+                return;
+            }
+
+            auto& body = uploadParser->get().body();
+            body.data = chunk->data.get();
+            body.size = chunkSize;
+
+            reading = true;
+            beast::get_lowest_layer(tcpStream).expires_after(std::chrono::seconds(30u));
+            http::async_read_some(tcpStream, buffer, *uploadParser,
+                                  beast::bind_front_handler(&session::on_read_chunk, shared_from_this(),
+                                                            static_cast<size_t>(chunk - chunks.begin())));
+        }
+
+        void on_read_chunk(size_t index,
+                           beast::error_code errorCode,
+                           std::size_t bytes_transferred)
+        {
+            boost::ignore_unused(bytes_transferred);
+            reading = false;
+            if (aborted) {
+                return;
+            }
+
+            // The chunk is full, this is not an error
+            if (http::error::need_buffer == errorCode) {
+                errorCode = {};
+            }
+            if (http::error::body_limit == errorCode) {
+                abort_upload();
+                return send_response(status_response(http::status::payload_too_large,
+                        uploadParser->get().version(), false, "Upload is too large"));
+            }
+            if (errorCode) {
+                abort_upload();
+                return fail(errorCode, "read_chunk");
+            }
+
+            Chunk& chunk = chunks[index];
+            chunk.size = chunkSize - uploadParser->get().body().size;
+            if (chunk.size > 0)
+            {
+                uploadSize += chunk.size;
+                chunk.pending = 2;
+
+                writeQueue.push_back(index);
+                write_chunk();
+
+                asio::post(hashStrand, [self = shared_from_this(), index] {
+                    self->sha256->update(self->chunks[index].data.get(), self->chunks[index].size);
+                    asio::post(self->tcpStream.get_executor(), [self, index] {
+                        self->release_chunk(index);
+                    });
+                });
+            }
+
+            if (uploadParser->is_done()) {
+                return finish_upload();
+            }
+            read_chunk();
+        }
+
+        void write_chunk()
+        {
+            // After an abort the file is closed: the queued chunks are dropped
+            if (writing || writeQueue.empty() || aborted) {
+                return;
+            }
+
+            writing = true;
+            const size_t index = writeQueue.front();
+#if defined(BOOST_ASIO_HAS_FILE)
+            asio::async_write(*file, asio::buffer(chunks[index].data.get(), chunks[index].size),
+                              beast::bind_front_handler(&session::on_write_chunk, shared_from_this(), index));
+#else
+            // One write at a time: the file is touched by a single pool thread, and only while `writing` is set
+            asio::post(fileExecutor, [self = shared_from_this(), index] {
+                beast::error_code errorCode;
+                const size_t written = self->file->write(self->chunks[index].data.get(), self->chunks[index].size,
+                                                         errorCode);
+                asio::post(self->tcpStream.get_executor(), beast::bind_front_handler(
+                        &session::on_write_chunk, self, index, errorCode, written));
+            });
+#endif
+        }
+
+        void on_write_chunk(size_t index,
+                            const beast::error_code& errorCode,
+                            std::size_t bytes_transferred)
+        {
+            boost::ignore_unused(bytes_transferred);
+            writing = false;
+            writeQueue.pop_front();
+
+            if (aborted) {
+                // Left open by abort_upload while this write was running
+                beast::error_code ignored;
+                if (file && file->is_open()) {
+                    file->close(ignored);
+                }
+                return;
+            }
+            if (errorCode) {
+                // The connection is dropped once the outstanding operations complete
+                abort_upload();
+                return fail(errorCode, "write_chunk");
+            }
+            release_chunk(index);
+            write_chunk();
+        }
+
+        void release_chunk(size_t index)
+        {
+            if (0 != --chunks[index].pending || aborted) {
+                return;
+            }
+            if (uploadParser->is_done()) {
+                return finish_upload();
+            }
+            if (!reading) {
+                read_chunk();
+            }
+        }
+
+        void finish_upload()
+        {
+            const bool busy = std::ranges::any_of(chunks, [](const Chunk& c) { return c.pending > 0; });
+            if (busy || aborted || !file || !file->is_open()) {
+                return;
+            }
+
+            beast::error_code errorCode;
+            file->close(errorCode);
+
+            const std::string body = std::format(R"({{"file":"{}","size":{},"sha256":"{}"}})",
+                                                 uploadPath, uploadSize, sha256->hexDigest());
+            http::response<http::string_body> response { http::status::created, uploadParser->get().version() };
+            response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+            response.set(http::field::content_type, "application/json");
+            response.keep_alive(uploadParser->get().keep_alive());
+            response.body() = body;
+            response.prepare_payload();
+
+            file.reset();
+            sha256.reset();
+            send_response(std::move(response));
+        }
+
+        void abort_upload()
+        {
+            // Outstanding writes and hash updates still hold the session, they complete into the void
+            aborted = true;
+            beast::error_code errorCode;
+            // A blocking write may be using the file on the pool: on_write_chunk closes it then
+            if (file && file->is_open() && !writing) {
+                file->close(errorCode);
+            }
+            std::filesystem::remove(uploadPath, errorCode);
         }
 
         void send_response(http::message_generator&& msg)
@@ -453,16 +874,21 @@ namespace HTTPS_Server_ASync
     {
         asio::io_context& ioContext;
         ssl::context& context;
+        const VirtualHosts& virtualHosts;
+        asio::thread_pool& hashPool;
+        asio::thread_pool& filePool;
         tcp::acceptor acceptor;
-        std::string_view docRoot;
 
     public:
 
         Listener(asio::io_context& ioc,
                  ssl::context& ctx,
-                 const tcp::endpoint& endpoint,
-                 std::string_view doc_root) :
-                 ioContext { ioc }, context { ctx }, acceptor { ioc }, docRoot { doc_root }
+                 const VirtualHosts& hosts,
+                 asio::thread_pool& hash_pool,
+                 asio::thread_pool& file_pool,
+                 const tcp::endpoint& endpoint) :
+                 ioContext { ioc }, context { ctx }, virtualHosts { hosts }, hashPool { hash_pool }, filePool { file_pool },
+                 acceptor { ioc }
         {
             beast::error_code errorCode;
 
@@ -520,7 +946,7 @@ namespace HTTPS_Server_ASync
             }
             else
             { // Create the session and run it
-                std::make_shared<session>(std::move(socket), context, docRoot)->run();
+                std::make_shared<session>(std::move(socket), context, virtualHosts, hashPool, filePool)->run();
             }
 
             // Accept another connection
@@ -531,17 +957,29 @@ namespace HTTPS_Server_ASync
 
     int runServer()
     {
-        constexpr std::string_view docRoot { "/"sv };
         constexpr uint32_t threads { 4 };
 
         try
         {
             asio::io_context ioContext { threads };
-            ssl::context ctx {ssl::context::tlsv13 };
-            load_server_certificate(ctx);
+
+            // Uploads are hashed and dynamic responses computed off the I/O threads, each on its own pool:
+            // a slow handler must not hold up the hashing of an upload and the other way round
+            asio::thread_pool hashPool { 2 };
+            // Upload writes without io_uring block: they run there instead of on the I/O threads
+            asio::thread_pool filePool { 2 };
+            asio::thread_pool apiPool { 2 };
+            std::filesystem::create_directories(uploadDir);
+
+            // One listener for every domain: each host brings its own certificate, routing table and cache
+            VirtualHosts virtualHosts { apiPool.get_executor() };
+            virtualHosts.add("www.example.com", { { "/", "/" } });
+            virtualHosts.add("static.example.com", { { "/", "/var/www/static" }, { "/images/", "/var/www/images" } });
+            virtualHosts.add("*.example.org", { { "/", "/var/www/example.org" } });
+            ssl::context& ctx = virtualHosts.listenerContext();
 
             const tcp::endpoint serverAddress = tcp::endpoint { ip::make_address(host), port };
-            std::make_shared<Listener>(ioContext,ctx, serverAddress, docRoot)->run();
+            std::make_shared<Listener>(ioContext,ctx, virtualHosts, hashPool, filePool, serverAddress)->run();
 
             // Run the I/O service on the requested number of threads
             std::vector<std::thread> workers;
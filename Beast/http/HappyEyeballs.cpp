@@ -0,0 +1,324 @@
+/**============================================================================
+Name        : HappyEyeballs.cpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : RFC 8305 style connect: staggered parallel attempts, endpoints ordered by health
+============================================================================**/
+
+#include "HappyEyeballs.h"
+
+#include <iostream>
+#include <format>
+#include <print>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/deferred.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/experimental/parallel_group.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
+#include <boost/system/system_error.hpp>
+#include <boost/core/ignore_unused.hpp>
+
+namespace
+{
+    using namespace HappyEyeballs;
+
+    // Connection attempts of one connect() call, kept alive by their handlers until the closed ones complete
+    struct Race
+    {
+        // Channel error first, then the outcome of the attempt and its index
+        using Channel = asio::experimental::concurrent_channel<
+                void(boost::system::error_code, boost::system::error_code, size_t)>;
+
+        Channel channel;
+        std::vector<tcp::socket> sockets;
+        std::vector<Clock::time_point> started;
+        std::vector<char> finished;
+
+        Race(const asio::any_io_executor& executor,
+             size_t attempts): channel { executor, attempts }, started(attempts), finished(attempts, 0)
+        {
+            sockets.reserve(attempts);
+            for (size_t i = 0; i < attempts; ++i)
+                sockets.emplace_back(executor);
+        }
+
+        static void start(const std::shared_ptr<Race>& self,
+                          size_t index,
+                          const tcp::endpoint& endpoint)
+        {
+            self->started[index] = Clock::now();
+            self->sockets[index].async_connect(endpoint, [self, index](const boost::system::error_code& errorCode) {
+                self->channel.try_send(boost::system::error_code {}, errorCode, index);
+            });
+        }
+
+        // The winner has been moved out: only the losers and the attempts never started are left
+        void closeAll() noexcept
+        {
+            boost::system::error_code ignored;
+            for (tcp::socket& socket: sockets) {
+                if (socket.is_open())
+                    socket.close(ignored);
+            }
+        }
+    };
+
+    // Takes `count` connections off a listener with a zero backlog and never accepts them: further SYNs to
+    // it are dropped, which is what a dead address looks like
+    std::vector<tcp::socket> fillBacklog(asio::io_context& ioCtx,
+                                         const tcp::endpoint& endpoint,
+                                         size_t count)
+    {
+        std::vector<tcp::socket> sockets;
+        // No reallocation: a socket with a pending connect must not move
+        sockets.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            sockets.emplace_back(ioCtx).async_connect(endpoint, [](const boost::system::error_code&) {});
+        }
+        ioCtx.run_for(std::chrono::milliseconds(100));
+        ioCtx.restart();
+        return sockets;
+    }
+}
+
+namespace HappyEyeballs
+{
+    Health::Health(HealthOptions options): options { options } {
+    }
+
+    double Health::failureAt(const Score& score,
+                             Clock::time_point now) const noexcept
+    {
+        const double halfLives = std::chrono::duration<double>(now - score.updated) / options.failureHalfLife;
+        return score.failure * std::exp2(-halfLives);
+    }
+
+    void Health::success(const tcp::endpoint& endpoint,
+                         Clock::duration latency)
+    {
+        std::lock_guard lock { mutex };
+        const Clock::time_point now = Clock::now();
+        Score& score = scores[endpoint];
+        score.latency = 0 == score.attempts ? latency : std::chrono::duration_cast<Clock::duration>(
+                options.alpha * latency + (1.0 - options.alpha) * score.latency);
+        score.failure = (1.0 - options.alpha) * failureAt(score, now);
+        score.updated = now;
+        ++score.attempts;
+    }
+
+    void Health::failure(const tcp::endpoint& endpoint)
+    {
+        std::lock_guard lock { mutex };
+        const Clock::time_point now = Clock::now();
+        Score& score = scores[endpoint];
+        score.failure = (1.0 - options.alpha) * failureAt(score, now) + options.alpha;
+        score.updated = now;
+        ++score.attempts;
+    }
+
+    void Health::outrun(const tcp::endpoint& endpoint,
+                        Clock::duration elapsed)
+    {
+        std::lock_guard lock { mutex };
+        Score& score = scores[endpoint];
+        if (0 == score.attempts) {
+            score.latency = elapsed;
+            score.updated = Clock::now();
+        } else if (elapsed > score.latency) {
+            // Only a lower bound of its connect time: it never lowers the average
+            score.latency = std::chrono::duration_cast<Clock::duration>(
+                    options.alpha * elapsed + (1.0 - options.alpha) * score.latency);
+        }
+        ++score.attempts;
+    }
+
+    Endpoints Health::order(Endpoints endpoints) const
+    {
+        {
+            std::lock_guard lock { mutex };
+            const Clock::time_point now = Clock::now();
+            const auto cost = [&](const tcp::endpoint& endpoint) -> Clock::duration {
+                const auto iter = scores.find(endpoint);
+                if (scores.end() == iter)
+                    return Clock::duration::min();
+                return iter->second.latency + std::chrono::duration_cast<Clock::duration>(
+                        options.failurePenalty * failureAt(iter->second, now));
+            };
+            std::ranges::stable_sort(endpoints, std::less {}, cost);
+        }
+
+        // RFC 8305, section 4: alternate the families so that a broken one costs a single attempt delay
+        Endpoints first, second;
+        for (const tcp::endpoint& endpoint: endpoints)
+            (endpoint.protocol() == endpoints.front().protocol() ? first : second).push_back(endpoint);
+
+        Endpoints ordered;
+        ordered.reserve(endpoints.size());
+        for (size_t i = 0; i < std::max(first.size(), second.size()); ++i) {
+            if (i < first.size())
+                ordered.push_back(first[i]);
+            if (i < second.size())
+                ordered.push_back(second[i]);
+        }
+        return ordered;
+    }
+
+    std::optional<Score> Health::score(const tcp::endpoint& endpoint) const
+    {
+        std::lock_guard lock { mutex };
+        const auto iter = scores.find(endpoint);
+        if (scores.end() == iter)
+            return std::nullopt;
+        Score score = iter->second;
+        score.failure = failureAt(score, Clock::now());
+        return score;
+    }
+
+    asio::awaitable<tcp::endpoint> connect(tcp::socket& socket,
+                                           Endpoints endpoints,
+                                           Options options)
+    {
+        if (endpoints.empty())
+            throw boost::system::system_error(asio::error::host_not_found, "connect");
+        if (options.health)
+            endpoints = options.health->order(std::move(endpoints));
+
+        const asio::any_io_executor executor = co_await asio::this_coro::executor;
+        const auto race = std::make_shared<Race>(executor, endpoints.size());
+        // Returning, throwing or being cancelled: the attempts still running are closed
+        const std::shared_ptr<void> closeOnExit { nullptr, [race](void*) { race->closeAll(); } };
+
+        const Clock::time_point deadline = Clock::now() + options.timeout;
+        asio::steady_timer timer { executor };
+        size_t next = 0, running = 0;
+        boost::system::error_code lastError = asio::error::host_unreachable;
+
+        const auto startNext = [&] {
+            Race::start(race, next, endpoints[next]);
+            ++next;
+            ++running;
+            // After the last attempt has started, the timer only stands for the deadline
+            timer.expires_at(next < endpoints.size() ? std::min(deadline, Clock::now() + options.attemptDelay)
+                                                     : deadline);
+        };
+
+        startNext();
+        while (running > 0 || next < endpoints.size())
+        {
+            if (0 == running) {
+                startNext();
+                continue;
+            }
+
+            auto [order, receiveError, attemptError, index, timerError] =
+                    co_await asio::experimental::make_parallel_group(
+                            race->channel.async_receive(asio::deferred),
+                            timer.async_wait(asio::deferred)
+                    ).async_wait(asio::experimental::wait_for_one(), asio::use_awaitable);
+
+            // Timer won and no attempt completed: start the next endpoint or give up. An attempt that completed
+            // at the same moment falls through with its result instead.
+            if (1 == order[0] && asio::error::operation_aborted == receiveError)
+            {
+                if (timerError)
+                    throw boost::system::system_error(timerError, "connect");
+                if (Clock::now() < deadline) {
+                    startNext();
+                    continue;
+                }
+                // Nothing answered in time: every attempt still running counts as failed
+                for (size_t i = 0; i < next && options.health; ++i) {
+                    if (!race->finished[i])
+                        options.health->failure(endpoints[i]);
+                }
+                throw boost::system::system_error(asio::error::timed_out, "connect");
+            }
+
+            if (receiveError)
+                throw boost::system::system_error(receiveError, "connect");
+            --running;
+            race->finished[index] = 1;
+
+            const Clock::time_point now = Clock::now();
+            if (!attemptError)
+            {
+                if (options.health)
+                {
+                    options.health->success(endpoints[index], now - race->started[index]);
+                    for (size_t i = 0; i < next; ++i) {
+                        if (!race->finished[i])
+                            options.health->outrun(endpoints[i], now - race->started[i]);
+                    }
+                }
+                socket = std::move(race->sockets[index]);
+                co_return endpoints[index];
+            }
+
+            // A refused or unreachable endpoint starts the next one right away
+            lastError = attemptError;
+            if (options.health)
+                options.health->failure(endpoints[index]);
+            if (next < endpoints.size())
+                startNext();
+        }
+        throw boost::system::system_error(lastError, "connect");
+    }
+}
+
+// Loopback only: 127.0.0.2 is a listener with a full backlog (dropped SYNs), 127.0.0.1 a live one.
+// The dead address comes first from the resolver; it costs one attempt delay, then nothing once learned.
+void HappyEyeballs::TestAll()
+{
+    using namespace std::chrono_literals;
+
+    asio::io_context ioCtx;
+    tcp::acceptor live { ioCtx, tcp::endpoint { asio::ip::make_address("127.0.0.1"), 0 } };
+    tcp::acceptor dead { ioCtx };
+    dead.open(tcp::v4());
+    dead.bind(tcp::endpoint { asio::ip::make_address("127.0.0.2"), 0 });
+    dead.listen(0);
+    std::vector<tcp::socket> backlog = fillBacklog(ioCtx, dead.local_endpoint(), 4);
+
+    const Endpoints endpoints { dead.local_endpoint(), live.local_endpoint() };
+    Health health;
+
+    asio::co_spawn(ioCtx, [&]() -> asio::awaitable<void> {
+        for (int i = 0; i < 5; ++i)
+        {
+            tcp::socket socket { co_await asio::this_coro::executor };
+            const Clock::time_point start = Clock::now();
+            const tcp::endpoint endpoint = co_await connect(socket, endpoints,
+                                                            Options { .attemptDelay = 100ms, .timeout = 2s,
+                                                                      .health = &health });
+            std::println("#{} connected to {} in {} us", i, endpoint.address().to_string(),
+                         (Clock::now() - start) / 1us);
+
+            tcp::socket accepted = co_await live.async_accept();
+            boost::ignore_unused(accepted);
+        }
+
+        for (const tcp::endpoint& endpoint: endpoints) {
+            if (const std::optional<Score> score = health.score(endpoint))
+                std::println("{:<16} latency {} us, failure {:.2f}, attempts {}", endpoint.address().to_string(),
+                             score->latency / 1us, score->failure, score->attempts);
+        }
+
+        // The SYNs still queued against the full backlog would be retried for minutes: run() must not wait for them
+        boost::system::error_code ignored;
+        for (tcp::socket& socket: backlog)
+            socket.close(ignored);
+        dead.close(ignored);
+    }, [](const std::exception_ptr& exc) {
+        if (exc)
+            std::rethrow_exception(exc);
+    });
+    ioCtx.run();
+}
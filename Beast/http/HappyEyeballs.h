@@ -0,0 +1,100 @@
+/**============================================================================
+Name        : HappyEyeballs.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : RFC 8305 style connect: staggered parallel attempts, endpoints ordered by health
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_HAPPYEYEBALLS_H
+#define BOOSTPROJECTS_HAPPYEYEBALLS_H
+
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+namespace HappyEyeballs
+{
+    namespace asio = boost::asio;
+    using tcp = asio::ip::tcp;
+    using Clock = std::chrono::steady_clock;
+    using Endpoints = std::vector<tcp::endpoint>;
+
+    struct HealthOptions
+    {
+        // Weight of the newest sample in the moving averages
+        double alpha { 0.3 };
+        // A failure score halves over that time without attempts: an endpoint that was down gets tried again
+        Clock::duration failureHalfLife { std::chrono::seconds(30) };
+        // Cost of a certain failure, added to the latency when ordering endpoints
+        Clock::duration failurePenalty { std::chrono::seconds(1) };
+    };
+
+    struct Score
+    {
+        // Moving average of connect times
+        Clock::duration latency { Clock::duration::zero() };
+        // Moving average of outcomes: 0 always connects, 1 always fails
+        double failure { 0.0 };
+        Clock::time_point updated;
+        uint64_t attempts { 0 };
+    };
+
+    // Connect outcomes per endpoint, shared by the connections of a process
+    class Health
+    {
+        const HealthOptions options;
+        mutable std::mutex mutex;
+        std::unordered_map<tcp::endpoint, Score> scores;
+
+        [[nodiscard]]
+        double failureAt(const Score& score,
+                         Clock::time_point now) const noexcept;
+
+    public:
+        explicit Health(HealthOptions options = {});
+
+        void success(const tcp::endpoint& endpoint,
+                     Clock::duration latency);
+
+        void failure(const tcp::endpoint& endpoint);
+
+        // An attempt cancelled after `elapsed` because another endpoint won: it was at least that slow
+        void outrun(const tcp::endpoint& endpoint,
+                    Clock::duration elapsed);
+
+        // Cheapest expected connect first, endpoints never tried keep the resolver order and go ahead of the
+        // known ones. Address families are then interleaved, starting with the family of the best endpoint.
+        [[nodiscard]]
+        Endpoints order(Endpoints endpoints) const;
+
+        [[nodiscard]]
+        std::optional<Score> score(const tcp::endpoint& endpoint) const;
+    };
+
+    struct Options
+    {
+        // RFC 8305 "Connection Attempt Delay": the next endpoint starts if the previous one hasn't connected by then
+        Clock::duration attemptDelay { std::chrono::milliseconds(250) };
+        Clock::duration timeout { std::chrono::seconds(10) };
+        // Outcomes are recorded there and the endpoints ordered by it, when set
+        Health* health { nullptr };
+    };
+
+    // Races the endpoints with staggered starts, a failed attempt starting the next one at once. The first
+    // connected socket is moved into `socket`, the other attempts are closed. Throws the last error when all
+    // of them fail, asio::error::timed_out after Options::timeout.
+    asio::awaitable<tcp::endpoint> connect(tcp::socket& socket,
+                                           Endpoints endpoints,
+                                           Options options = {});
+
+    void TestAll();
+}
+
+#endif //BOOSTPROJECTS_HAPPYEYEBALLS_H
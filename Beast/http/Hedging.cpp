@@ -0,0 +1,332 @@
+/**============================================================================
+Name        : Hedging.cpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Hedged requests and a retry budget on top of the pooled HTTPS client
+============================================================================**/
+
+#include "Hedging.h"
+
+#include <iostream>
+#include <format>
+#include <print>
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/deferred.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/as_tuple.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/bind_cancellation_slot.hpp>
+#include <boost/asio/cancellation_signal.hpp>
+#include <boost/asio/experimental/parallel_group.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
+#include <boost/system/system_error.hpp>
+
+#include "trust_store.hpp"
+
+namespace
+{
+    using namespace Hedging;
+    namespace http = boost::beast::http;
+    namespace ssl = asio::ssl;
+
+    // Samples between two quantile updates
+    constexpr size_t updateEvery { 32 };
+
+    // Attempts of one request. It is owned by their completion handlers too: a cancelled attempt finishes
+    // after the request has returned.
+    struct Race
+    {
+        using Channel = asio::experimental::concurrent_channel<void(boost::system::error_code, size_t, Response)>;
+
+        // The attempts and their cancellation run on it: a cancellation_signal is not thread-safe
+        asio::strand<asio::any_io_executor> strand;
+        const std::vector<Origin> origins;
+        const Request request;
+        Channel channel;
+        std::vector<asio::cancellation_signal> signals;
+        std::vector<Clock::time_point> started;
+        // Set on the strand when an attempt completes: its signal must not be emitted any more
+        std::vector<char> finished;
+
+        Race(const asio::any_io_executor& executor,
+             std::span<const Origin> origins,
+             Request request,
+             size_t attempts)
+            : strand { asio::make_strand(executor) }, origins(origins.begin(), origins.end()),
+              request { std::move(request) }, channel { executor, attempts }, signals(attempts), started(attempts),
+              finished(attempts, 0) {
+        }
+
+        void launch(ConnectionPool::Pool& pool,
+                    const std::shared_ptr<Race>& self,
+                    size_t attempt)
+        {
+            started[attempt] = Clock::now();
+            asio::co_spawn(strand, ConnectionPool::send(pool, origins[attempt % origins.size()], request),
+                           asio::bind_cancellation_slot(signals[attempt].slot(),
+                                                        [self, attempt](std::exception_ptr exc, Response response) {
+                self->finished[attempt] = 1;
+                self->channel.try_send(ConnectionPool::errorOf(exc), attempt, std::move(response));
+            }));
+        }
+
+        // Signals of attempts never launched have no handler: emitting them does nothing
+        static void cancelAll(const std::shared_ptr<Race>& self)
+        {
+            asio::dispatch(self->strand, [self] {
+                for (size_t attempt = 0; attempt < self->signals.size(); ++attempt) {
+                    if (!self->finished[attempt])
+                        self->signals[attempt].emit(asio::cancellation_type::terminal);
+                }
+            });
+        }
+    };
+}
+
+namespace Hedging
+{
+    LatencyTracker::LatencyTracker(double quantile,
+                                   size_t windowSize): windowSize { std::max<size_t>(windowSize, 1) },
+                                                       quantile { quantile }
+    {
+        window.reserve(this->windowSize);
+        scratch.reserve(this->windowSize);
+    }
+
+    void LatencyTracker::add(Clock::duration latency)
+    {
+        std::lock_guard lock { mutex };
+        if (window.size() < windowSize)
+            window.push_back(latency);
+        else
+            window[next] = latency;
+        next = (next + 1) % windowSize;
+        ++sinceUpdate;
+    }
+
+    Clock::duration LatencyTracker::value(size_t minSamples)
+    {
+        std::lock_guard lock { mutex };
+        if (window.empty() || window.size() < minSamples)
+            return Clock::duration::zero();
+
+        if (sinceUpdate >= updateEvery || Clock::duration::zero() == cached)
+        {
+            scratch.assign(window.begin(), window.end());
+            const auto nth = scratch.begin() + static_cast<std::ptrdiff_t>(
+                    std::min(scratch.size() - 1, static_cast<size_t>(quantile * double(scratch.size()))));
+            std::ranges::nth_element(scratch, nth);
+            cached = *nth;
+            sinceUpdate = 0;
+        }
+        return cached;
+    }
+
+    RetryBudget::RetryBudget(double ratio,
+                             double perSecond,
+                             double capacity)
+        : tokens { std::min(perSecond, capacity) }, ratio { ratio }, perSecond { perSecond }, capacity { capacity } {
+    }
+
+    void RetryBudget::refill(Clock::time_point now)
+    {
+        tokens = std::min(capacity, tokens + perSecond * std::chrono::duration<double>(now - refilled).count());
+        refilled = now;
+    }
+
+    void RetryBudget::deposit()
+    {
+        std::lock_guard lock { mutex };
+        refill(Clock::now());
+        tokens = std::min(capacity, tokens + ratio);
+    }
+
+    bool RetryBudget::withdraw()
+    {
+        std::lock_guard lock { mutex };
+        refill(Clock::now());
+        if (tokens < 1.0)
+            return false;
+        tokens -= 1.0;
+        return true;
+    }
+
+    Client::Client(ConnectionPool::Pool& pool,
+                   Options options)
+        : pool { pool }, options { options },
+          latencies { options.quantile, options.window },
+          budget { options.budgetRatio, options.budgetPerSecond, options.budgetCapacity } {
+    }
+
+    Clock::duration Client::delay()
+    {
+        const Clock::duration measured = latencies.value(options.minSamples);
+        return Clock::duration::zero() == measured ? options.initialDelay : std::max(options.minDelay, measured);
+    }
+
+    asio::awaitable<Response> Client::send(const Origin& origin,
+                                           Request request)
+    {
+        co_return co_await send(std::span<const Origin> { &origin, 1 }, std::move(request));
+    }
+
+    asio::awaitable<Response> Client::send(std::span<const Origin> origins,
+                                           Request request)
+    {
+        if (origins.empty())
+            throw std::invalid_argument("Hedging::Client::send: no origin");
+
+        ++requests;
+        budget.deposit();
+        const bool repeatable = ConnectionPool::idempotent(request.method());
+        const size_t maxAttempts = repeatable ? 2 + options.maxRetries : 1;
+
+        const asio::any_io_executor executor = co_await asio::this_coro::executor;
+        const auto race = std::make_shared<Race>(executor, origins, std::move(request), maxAttempts);
+        // Whatever way this coroutine ends, cancelled by the caller included, no attempt outlives it for long
+        const std::shared_ptr<void> cancelOnExit { nullptr, [race](void*) { Race::cancelAll(race); } };
+
+        const Clock::duration hedgeDelay = delay();
+        asio::steady_timer timer { executor, hedgeDelay };
+        size_t launched = 0, running = 0, retried = 0;
+        size_t hedgeAttempt = maxAttempts;
+        bool hedged = !repeatable;
+        boost::system::error_code lastError;
+
+        race->launch(pool, race, launched++);
+        ++running;
+        while (running > 0)
+        {
+            boost::system::error_code error;
+            size_t attempt = 0;
+            Response response;
+            if (!hedged)
+            {
+                auto [order, receiveError, receivedAttempt, receivedResponse, timerError] =
+                        co_await asio::experimental::make_parallel_group(
+                                race->channel.async_receive(asio::deferred),
+                                timer.async_wait(asio::deferred)
+                        ).async_wait(asio::experimental::wait_for_one(), asio::use_awaitable);
+
+                if (1 == order[0])
+                {
+                    hedged = true;
+                    // The attempt completed as the timer fired: its result was received, it is handled below
+                    if (asio::error::operation_aborted == receiveError)
+                    {
+                        // The original attempt is past the quantile: a second one races it
+                        if (budget.withdraw()) {
+                            ++hedges;
+                            hedgeAttempt = launched;
+                            race->launch(pool, race, launched++);
+                            ++running;
+                        } else {
+                            ++denied;
+                        }
+                        continue;
+                    }
+                }
+                error = receiveError;
+                attempt = receivedAttempt;
+                response = std::move(receivedResponse);
+            }
+            else
+            {
+                std::tie(error, attempt, response) =
+                        co_await race->channel.async_receive(asio::as_tuple(asio::use_awaitable));
+            }
+
+            --running;
+            if (!error)
+            {
+                latencies.add(Clock::now() - race->started[attempt]);
+                if (hedgeAttempt == attempt)
+                    ++hedgeWins;
+                co_return response;
+            }
+
+            lastError = error;
+            if (repeatable && retried < options.maxRetries && launched < maxAttempts)
+            {
+                if (budget.withdraw()) {
+                    ++retries;
+                    ++retried;
+                    race->launch(pool, race, launched++);
+                    ++running;
+                    if (!hedged)
+                        timer.expires_after(hedgeDelay);
+                } else {
+                    ++denied;
+                }
+            }
+        }
+        throw boost::system::system_error(lastError, "hedged send");
+    }
+
+    Stats Client::stats() const noexcept
+    {
+        return Stats {
+            .requests = requests.load(),
+            .hedges = hedges.load(),
+            .hedgeWins = hedgeWins.load(),
+            .retries = retries.load(),
+            .denied = denied.load()
+        };
+    }
+}
+
+// HTTPS_Server on 8443: 16 concurrent workers, 2000 GETs. The hedge delay settles on the measured p95.
+void Hedging::TestAll()
+{
+    using namespace std::chrono_literals;
+    constexpr size_t workers { 16 };
+    constexpr size_t requestsPerWorker { 125 };
+
+    asio::io_context ioCtx;
+    ssl::context ctx { ssl::context::tlsv13_client };
+    load_shared_root_certificates(ctx);
+    ConnectionPool::Pool pool { ioCtx.get_executor(), ctx, ConnectionPool::Options { .maxPerHost = 32 } };
+    Client client { pool };
+    const Origin origin { "127.0.0.1", 8443 };
+
+    std::vector<Clock::duration> latencies;
+    size_t done = 0, failed = 0;
+    for (size_t i = 0; i < workers; ++i)
+    {
+        asio::co_spawn(ioCtx, [&]() -> asio::awaitable<void> {
+            for (size_t n = 0; n < requestsPerWorker; ++n)
+            {
+                const Clock::time_point start = Clock::now();
+                const auto [exc, response] = co_await asio::co_spawn(ioCtx,
+                        client.send(origin, Request { http::verb::get, "/", 11 }), asio::as_tuple(asio::use_awaitable));
+                if (exc)
+                    ++failed;
+                else
+                    latencies.push_back(Clock::now() - start);
+            }
+        }, [&](const std::exception_ptr& exc) {
+            if (exc)
+                std::rethrow_exception(exc);
+            if (workers == ++done)
+                pool.close();
+        });
+    }
+    ioCtx.run();
+
+    std::ranges::sort(latencies);
+    const Stats stats = client.stats();
+    std::println("{} requests, {} failed: {} hedges ({} won), {} retries, {} denied by the budget",
+                 stats.requests, failed, stats.hedges, stats.hedgeWins, stats.retries, stats.denied);
+    if (!latencies.empty())
+        std::println("p50 {} us, p99 {} us, hedge delay {} us", latencies[latencies.size() / 2] / 1us,
+                     latencies[latencies.size() * 99 / 100] / 1us, client.delay() / 1us);
+}
@@ -0,0 +1,145 @@
+/**============================================================================
+Name        : Hedging.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Hedged requests and a retry budget on top of the pooled HTTPS client
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_HEDGING_H
+#define BOOSTPROJECTS_HEDGING_H
+
+#include <vector>
+#include <span>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+
+#include <boost/asio/awaitable.hpp>
+
+#include "ConnectionPool.h"
+
+namespace Hedging
+{
+    namespace asio = boost::asio;
+
+    using Clock = std::chrono::steady_clock;
+    using ConnectionPool::Origin;
+    using ConnectionPool::Request;
+    using ConnectionPool::Response;
+
+    // Latency quantile over the last requests, recomputed every few samples rather than on each call
+    class LatencyTracker
+    {
+        std::mutex mutex;
+        std::vector<Clock::duration> window;
+        // Copy of the window for nth_element, kept to avoid an allocation per update
+        std::vector<Clock::duration> scratch;
+        const size_t windowSize;
+        size_t next { 0 };
+        size_t sinceUpdate { 0 };
+        Clock::duration cached { Clock::duration::zero() };
+        const double quantile;
+
+    public:
+        LatencyTracker(double quantile,
+                       size_t windowSize);
+
+        void add(Clock::duration latency);
+
+        // Zero until the window has `minSamples` entries
+        [[nodiscard]]
+        Clock::duration value(size_t minSamples);
+    };
+
+    // Token bucket shared by hedges and retries: every request earns `ratio` of a token, every extra attempt
+    // spends one. `perSecond` keeps a few retries possible at low traffic.
+    class RetryBudget
+    {
+        std::mutex mutex;
+        double tokens;
+        Clock::time_point refilled { Clock::now() };
+        const double ratio;
+        const double perSecond;
+        const double capacity;
+
+        void refill(Clock::time_point now);
+
+    public:
+        RetryBudget(double ratio,
+                    double perSecond,
+                    double capacity);
+
+        void deposit();
+
+        [[nodiscard]]
+        bool withdraw();
+    };
+
+    struct Options
+    {
+        // A request still running at this latency quantile gets a hedge
+        double quantile { 0.95 };
+        size_t window { 1024 };
+        // Before that many samples the quantile is not trusted and `initialDelay` is used
+        size_t minSamples { 100 };
+        Clock::duration initialDelay { std::chrono::milliseconds(50) };
+        // Lower bound of the hedge delay: below it a hedge doubles the load for nothing
+        Clock::duration minDelay { std::chrono::milliseconds(2) };
+        // Retries after a failed attempt, hedges not counted
+        uint32_t maxRetries { 1 };
+        // Budget: at most ~10% extra attempts, plus 10 per second
+        double budgetRatio { 0.1 };
+        double budgetPerSecond { 10 };
+        double budgetCapacity { 100 };
+    };
+
+    struct Stats
+    {
+        uint64_t requests { 0 };
+        uint64_t hedges { 0 };
+        // Requests answered by the hedge rather than the original attempt
+        uint64_t hedgeWins { 0 };
+        uint64_t retries { 0 };
+        // Hedges or retries skipped because the budget was empty
+        uint64_t denied { 0 };
+    };
+
+    class Client
+    {
+        ConnectionPool::Pool& pool;
+        const Options options;
+        LatencyTracker latencies;
+        RetryBudget budget;
+
+        std::atomic<uint64_t> requests { 0 };
+        std::atomic<uint64_t> hedges { 0 };
+        std::atomic<uint64_t> hedgeWins { 0 };
+        std::atomic<uint64_t> retries { 0 };
+        std::atomic<uint64_t> denied { 0 };
+
+    public:
+        explicit Client(ConnectionPool::Pool& pool,
+                        Options options = {});
+
+        // Only idempotent requests are hedged or retried. The hedge goes to the next origin of the list,
+        // or to another pooled connection of the same one; the slower attempt is cancelled.
+        asio::awaitable<Response> send(std::span<const Origin> origins,
+                                       Request request);
+
+        asio::awaitable<Response> send(const Origin& origin,
+                                       Request request);
+
+        // Current hedge delay
+        [[nodiscard]]
+        Clock::duration delay();
+
+        [[nodiscard]]
+        Stats stats() const noexcept;
+    };
+
+    void TestAll();
+}
+
+#endif //BOOSTPROJECTS_HEDGING_H
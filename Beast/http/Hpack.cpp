@@ -0,0 +1,429 @@
+/**============================================================================
+Name        : Hpack.cpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : HPACK header compression for HTTP/2 (RFC 7541)
+============================================================================**/
+
+#include "Hpack.h"
+
+#include <array>
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+    using namespace Hpack;
+
+    struct StaticEntry
+    {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    // RFC 7541, Appendix A. Index 1 is the first element.
+    constexpr std::array<StaticEntry, 61> staticTable {{
+        { ":authority", "" },
+        { ":method", "GET" },
+        { ":method", "POST" },
+        { ":path", "/" },
+        { ":path", "/index.html" },
+        { ":scheme", "http" },
+        { ":scheme", "https" },
+        { ":status", "200" },
+        { ":status", "204" },
+        { ":status", "206" },
+        { ":status", "304" },
+        { ":status", "400" },
+        { ":status", "404" },
+        { ":status", "500" },
+        { "accept-charset", "" },
+        { "accept-encoding", "gzip, deflate" },
+        { "accept-language", "" },
+        { "accept-ranges", "" },
+        { "accept", "" },
+        { "access-control-allow-origin", "" },
+        { "age", "" },
+        { "allow", "" },
+        { "authorization", "" },
+        { "cache-control", "" },
+        { "content-disposition", "" },
+        { "content-encoding", "" },
+        { "content-language", "" },
+        { "content-length", "" },
+        { "content-location", "" },
+        { "content-range", "" },
+        { "content-type", "" },
+        { "cookie", "" },
+        { "date", "" },
+        { "etag", "" },
+        { "expect", "" },
+        { "expires", "" },
+        { "from", "" },
+        { "host", "" },
+        { "if-match", "" },
+        { "if-modified-since", "" },
+        { "if-none-match", "" },
+        { "if-range", "" },
+        { "if-unmodified-since", "" },
+        { "last-modified", "" },
+        { "link", "" },
+        { "location", "" },
+        { "max-forwards", "" },
+        { "proxy-authenticate", "" },
+        { "proxy-authorization", "" },
+        { "range", "" },
+        { "referer", "" },
+        { "refresh", "" },
+        { "retry-after", "" },
+        { "server", "" },
+        { "set-cookie", "" },
+        { "strict-transport-security", "" },
+        { "transfer-encoding", "" },
+        { "user-agent", "" },
+        { "vary", "" },
+        { "via", "" },
+        { "www-authenticate", "" },
+    }};
+
+    // Code lengths of RFC 7541, Appendix B, symbols 0..255 and EOS (256).
+    // The code is canonical: codes of one length are consecutive in symbol order, so lengths are enough.
+    constexpr std::array<uint8_t, 257> huffmanLengths {
+        13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28,
+        28, 28, 28, 28,  6, 10, 10, 12, 13,  6,  8, 11, 10, 10,  8, 11,  8,  6,  6,  6,  5,  5,  5,  6,  6,  6,  6,  6,
+         6,  6,  7,  8, 15,  6, 12, 10, 13,  6,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,
+         7,  7,  7,  7,  8,  7,  8, 13, 19, 13, 14,  6, 15,  5,  6,  5,  6,  5,  6,  6,  6,  5,  7,  7,  6,  6,  6,  5,
+         6,  7,  6,  5,  5,  6,  7,  7,  7,  7,  7, 15, 11, 14, 13, 28, 20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23,
+        23, 23, 24, 23, 24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24, 22, 21, 20, 22, 22, 23, 23, 21,
+        23, 22, 22, 24, 21, 22, 23, 23, 21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23, 26, 26, 20, 19,
+        22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25, 19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+        20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23, 26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27,
+        27, 27, 27, 26, 30
+    };
+
+    constexpr uint32_t maxCodeLength { 30 };
+    constexpr uint16_t eosSymbol { 256 };
+
+    struct HuffmanTable
+    {
+        std::array<uint32_t, 257> codes {};
+        // Canonical decoding: per length, the first code, the number of codes and where its symbols start
+        std::array<uint32_t, maxCodeLength + 1> firstCode {};
+        std::array<uint32_t, maxCodeLength + 1> count {};
+        std::array<uint32_t, maxCodeLength + 1> offset {};
+        std::array<uint16_t, 257> symbols {};
+
+        HuffmanTable()
+        {
+            std::iota(symbols.begin(), symbols.end(), uint16_t { 0 });
+            std::ranges::stable_sort(symbols, {}, [](uint16_t symbol) { return huffmanLengths[symbol]; });
+
+            uint32_t code = 0;
+            uint32_t length = huffmanLengths[symbols.front()];
+            for (size_t i = 0; i < symbols.size(); ++i)
+            {
+                const uint32_t symbolLength = huffmanLengths[symbols[i]];
+                if (i > 0)
+                    code = (code + 1) << (symbolLength - length);
+                length = symbolLength;
+                if (0 == count[length]) {
+                    firstCode[length] = code;
+                    offset[length] = static_cast<uint32_t>(i);
+                }
+                ++count[length];
+                codes[symbols[i]] = code;
+            }
+        }
+    };
+
+    const HuffmanTable& huffmanTable()
+    {
+        static const HuffmanTable table;
+        return table;
+    }
+
+    bool decodeInteger(std::span<const uint8_t>& input,
+                       uint8_t prefixBits,
+                       uint64_t& value)
+    {
+        if (input.empty())
+            return false;
+
+        const uint8_t mask = static_cast<uint8_t>((1U << prefixBits) - 1);
+        value = input.front() & mask;
+        input = input.subspan(1);
+        if (value < mask)
+            return true;
+
+        for (uint32_t shift = 0; shift <= 56; shift += 7)
+        {
+            if (input.empty())
+                return false;
+            const uint8_t byte = input.front();
+            input = input.subspan(1);
+            value += static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (0 == (byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    void encodeInteger(std::string& output,
+                       uint8_t prefixBits,
+                       uint8_t firstByteFlags,
+                       uint64_t value)
+    {
+        const uint8_t mask = static_cast<uint8_t>((1U << prefixBits) - 1);
+        if (value < mask) {
+            output.push_back(static_cast<char>(firstByteFlags | value));
+            return;
+        }
+        output.push_back(static_cast<char>(firstByteFlags | mask));
+        value -= mask;
+        while (value >= 0x80) {
+            output.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        output.push_back(static_cast<char>(value));
+    }
+
+    bool decodeString(std::span<const uint8_t>& input,
+                      std::string& output)
+    {
+        if (input.empty())
+            return false;
+
+        const bool huffman = 0 != (input.front() & 0x80);
+        uint64_t length = 0;
+        if (!decodeInteger(input, 7, length) || length > input.size())
+            return false;
+
+        const std::span<const uint8_t> data = input.first(length);
+        input = input.subspan(length);
+
+        output.clear();
+        if (huffman)
+            return huffmanDecode(data, output);
+        output.assign(reinterpret_cast<const char*>(data.data()), data.size());
+        return true;
+    }
+
+    void encodeString(std::string& output,
+                      std::string_view value)
+    {
+        const size_t huffmanSize = huffmanEncodedSize(value);
+        if (huffmanSize < value.size()) {
+            encodeInteger(output, 7, 0x80, huffmanSize);
+            huffmanEncode(value, output);
+        } else {
+            encodeInteger(output, 7, 0x00, value.size());
+            output.append(value);
+        }
+    }
+}
+
+namespace Hpack
+{
+    bool huffmanDecode(std::span<const uint8_t> input,
+                       std::string& output)
+    {
+        const HuffmanTable& table = huffmanTable();
+
+        uint32_t code = 0;
+        uint32_t length = 0;
+        for (const uint8_t byte: input)
+        {
+            for (int bit = 7; bit >= 0; --bit)
+            {
+                code = (code << 1) | ((byte >> bit) & 1U);
+                if (++length > maxCodeLength)
+                    return false;
+                if (code - table.firstCode[length] < table.count[length] && code >= table.firstCode[length])
+                {
+                    const uint16_t symbol = table.symbols[table.offset[length] + code - table.firstCode[length]];
+                    if (eosSymbol == symbol)
+                        return false;
+                    output.push_back(static_cast<char>(symbol));
+                    code = 0;
+                    length = 0;
+                }
+            }
+        }
+
+        // Padding: fewer than 8 bits, all ones (the most significant bits of EOS)
+        return length < 8 && code == (1U << length) - 1;
+    }
+
+    void huffmanEncode(std::string_view input,
+                       std::string& output)
+    {
+        const HuffmanTable& table = huffmanTable();
+
+        uint64_t bits = 0;
+        uint32_t pending = 0;
+        for (const unsigned char c: input)
+        {
+            bits = (bits << huffmanLengths[c]) | table.codes[c];
+            pending += huffmanLengths[c];
+            while (pending >= 8) {
+                pending -= 8;
+                output.push_back(static_cast<char>(bits >> pending));
+            }
+        }
+        if (pending > 0)
+            output.push_back(static_cast<char>((bits << (8 - pending)) | (0xFF >> pending)));
+    }
+
+    size_t huffmanEncodedSize(std::string_view input) noexcept
+    {
+        size_t bits = 0;
+        for (const unsigned char c: input)
+            bits += huffmanLengths[c];
+        return (bits + 7) / 8;
+    }
+
+    void DynamicTable::evict(size_t required)
+    {
+        while (!entries.empty() && size + required > maxSize) {
+            size -= entries.back().name.size() + entries.back().value.size() + 32;
+            entries.pop_back();
+        }
+    }
+
+    void DynamicTable::setMaxSize(size_t value)
+    {
+        maxSize = value;
+        evict(0);
+    }
+
+    void DynamicTable::add(HeaderField field)
+    {
+        // An entry larger than the table empties it and is not added
+        const size_t entrySize = field.name.size() + field.value.size() + 32;
+        evict(entrySize);
+        if (entrySize > maxSize)
+            return;
+        size += entrySize;
+        entries.push_front(std::move(field));
+    }
+
+    const HeaderField* DynamicTable::at(size_t index) const noexcept
+    {
+        return index < entries.size() ? &entries[index] : nullptr;
+    }
+
+    Decoder::Decoder(size_t headerListLimit): headerListLimit { headerListLimit } {
+    }
+
+    DecodeResult Decoder::decode(std::span<const uint8_t> block,
+                                 HeaderList& headers)
+    {
+        const auto lookup = [this](uint64_t index, HeaderField& field) -> bool {
+            if (0 == index)
+                return false;
+            if (index <= staticTable.size()) {
+                field.name = staticTable[index - 1].name;
+                field.value = staticTable[index - 1].value;
+                return true;
+            }
+            const HeaderField* entry = table.at(index - staticTable.size() - 1);
+            if (nullptr == entry)
+                return false;
+            field = *entry;
+            return true;
+        };
+
+        // RFC 9113, section 6.5.2: name and value octets plus 32 per field. Past the limit the block is still
+        // decoded, since the dynamic table must stay in step with the peer's encoder, but nothing is kept.
+        size_t listSize = 0;
+        const auto emit = [&](HeaderField&& field) {
+            listSize += field.name.size() + field.value.size() + 32;
+            if (listSize <= headerListLimit)
+                headers.push_back(std::move(field));
+        };
+        bool fieldSeen = false;
+
+        while (!block.empty())
+        {
+            const uint8_t first = block.front();
+            HeaderField field;
+            uint64_t index = 0;
+
+            if (first & 0x80)
+            {
+                // Indexed header field
+                if (!decodeInteger(block, 7, index) || !lookup(index, field))
+                    return DecodeResult::CompressionError;
+                fieldSeen = true;
+                emit(std::move(field));
+            }
+            else if (0x20 == (first & 0xE0))
+            {
+                // Dynamic table size update: RFC 7541, section 4.2 allows it only at the start of a block
+                if (fieldSeen || !decodeInteger(block, 5, index) || index > tableSizeLimit)
+                    return DecodeResult::CompressionError;
+                table.setMaxSize(index);
+            }
+            else
+            {
+                // Literal: with incremental indexing (01), without indexing (0000) or never indexed (0001)
+                const bool indexing = 0x40 == (first & 0xC0);
+                if (!decodeInteger(block, indexing ? 6 : 4, index))
+                    return DecodeResult::CompressionError;
+                if (0 != index) {
+                    if (!lookup(index, field))
+                        return DecodeResult::CompressionError;
+                } else if (!decodeString(block, field.name)) {
+                    return DecodeResult::CompressionError;
+                }
+                if (!decodeString(block, field.value))
+                    return DecodeResult::CompressionError;
+
+                fieldSeen = true;
+                if (indexing)
+                    table.add(field);
+                emit(std::move(field));
+            }
+        }
+
+        if (listSize > headerListLimit) {
+            headers.clear();
+            return DecodeResult::HeaderListTooLarge;
+        }
+        return DecodeResult::Ok;
+    }
+
+    void Encoder::encode(std::string_view name,
+                         std::string_view value,
+                         std::string& output) const
+    {
+        size_t nameIndex = 0;
+        for (size_t i = 0; i < staticTable.size(); ++i)
+        {
+            if (staticTable[i].name != name)
+                continue;
+            if (staticTable[i].value == value) {
+                // Indexed header field
+                encodeInteger(output, 7, 0x80, i + 1);
+                return;
+            }
+            if (0 == nameIndex)
+                nameIndex = i + 1;
+        }
+
+        // Literal header field without indexing
+        encodeInteger(output, 4, 0x00, nameIndex);
+        if (0 == nameIndex)
+            encodeString(output, name);
+        encodeString(output, value);
+    }
+
+    void Encoder::encode(const HeaderList& headers,
+                         std::string& output) const
+    {
+        for (const HeaderField& field: headers)
+            encode(field.name, field.value, output);
+    }
+}
@@ -0,0 +1,103 @@
+/**============================================================================
+Name        : Hpack.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : HPACK header compression for HTTP/2 (RFC 7541)
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_HPACK_H
+#define BOOSTPROJECTS_HPACK_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <span>
+#include <limits>
+#include <cstdint>
+
+namespace Hpack
+{
+    struct HeaderField
+    {
+        std::string name;
+        std::string value;
+    };
+
+    using HeaderList = std::vector<HeaderField>;
+
+    enum class DecodeResult
+    {
+        Ok,
+        // The block is malformed: a connection error, the dynamic table can no longer be trusted
+        CompressionError,
+        // The block was decoded and the dynamic table updated, but the fields are dropped
+        HeaderListTooLarge
+    };
+
+    [[nodiscard]]
+    bool huffmanDecode(std::span<const uint8_t> input,
+                       std::string& output);
+
+    void huffmanEncode(std::string_view input,
+                       std::string& output);
+
+    [[nodiscard]]
+    size_t huffmanEncodedSize(std::string_view input) noexcept;
+
+    class DynamicTable
+    {
+        // Newest entry first, as the dynamic table is indexed
+        std::deque<HeaderField> entries;
+        size_t size { 0 };
+        size_t maxSize { 4096 };
+
+        void evict(size_t required);
+
+    public:
+        void setMaxSize(size_t value);
+        void add(HeaderField field);
+
+        [[nodiscard]]
+        const HeaderField* at(size_t index) const noexcept;
+
+        [[nodiscard]]
+        size_t maxTableSize() const noexcept {
+            return maxSize;
+        }
+    };
+
+    class Decoder
+    {
+        DynamicTable table;
+        // The limit we announced with SETTINGS_HEADER_TABLE_SIZE
+        size_t tableSizeLimit { 4096 };
+        // The limit we announced with SETTINGS_MAX_HEADER_LIST_SIZE
+        size_t headerListLimit;
+
+    public:
+        explicit Decoder(size_t headerListLimit = std::numeric_limits<size_t>::max());
+
+        // Decodes one complete header block into `headers`
+        [[nodiscard]]
+        DecodeResult decode(std::span<const uint8_t> block,
+                            HeaderList& headers);
+    };
+
+    // Stateless encoder: static table indices and literals without indexing, Huffman coded when shorter.
+    // Never touching the dynamic table keeps it correct whatever SETTINGS_HEADER_TABLE_SIZE the peer sends.
+    class Encoder
+    {
+    public:
+        void encode(std::string_view name,
+                    std::string_view value,
+                    std::string& output) const;
+
+        void encode(const HeaderList& headers,
+                    std::string& output) const;
+    };
+}
+
+#endif //BOOSTPROJECTS_HPACK_H
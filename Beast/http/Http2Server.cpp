@@ -0,0 +1,1089 @@
+/**============================================================================
+Name        : Http2Server.cpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Experimental HTTP/2 (h2c, prior knowledge) server on top of Beast
+============================================================================**/
+
+#include "Http2Server.h"
+
+#include <iostream>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <map>
+#include <thread>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <tuple>
+
+#include <boost/asio.hpp>
+#include <boost/asio/as_tuple.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/experimental/awaitable_operators.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+
+#include "Hpack.h"
+#include "RequestHandler.h"
+
+namespace
+{
+    namespace asio  = boost::asio;
+    namespace beast = boost::beast;
+    namespace http  = beast::http;
+    namespace ip    = asio::ip;
+
+    using tcp = ip::tcp;
+    using Clock = std::chrono::steady_clock;
+    using RequestHandler::handle_request;
+    using namespace asio::experimental::awaitable_operators;
+
+    constexpr std::string_view host { "0.0.0.0" };
+    constexpr uint16_t port { 8082 };
+    constexpr std::string_view docRoot { "/tmp/www" };
+
+    constexpr std::string_view clientPreface { "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n" };
+    constexpr size_t frameHeaderSize { 9 };
+    constexpr int64_t defaultWindow { 65'535 };
+    constexpr int64_t maxWindow { 0x7FFF'FFFF };
+
+    // We never announce a larger SETTINGS_MAX_FRAME_SIZE, so this bounds every frame we accept
+    constexpr uint32_t maxFrameSize { 16'384 };
+    constexpr uint32_t maxConcurrentStreams { 128 };
+    constexpr size_t headerBlockLimit { 64 * 1024 };
+    // Decoded size of a header list (RFC 9113, section 6.5.2), announced with SETTINGS_MAX_HEADER_LIST_SIZE:
+    // HPACK lets a small block expand into far more memory than the block itself
+    constexpr uint32_t maxHeaderListSize { 64 * 1024 };
+    constexpr size_t requestBodyLimit { 1024 * 1024 };
+
+    // Frames queued but not yet written: reading and DATA scheduling pause above this
+    constexpr size_t outboundLimit { 256 * 1024 };
+    constexpr size_t readChunk { 64 * 1024 };
+    constexpr std::chrono::seconds http1Timeout { 30 };
+    // The whole client preface must arrive within this time
+    constexpr std::chrono::seconds prefaceTimeout { 10 };
+    // Nothing received and nothing being written that long: the connection gets a GOAWAY and is closed
+    constexpr std::chrono::seconds idleTimeout { 60 };
+    // A single write of queued frames: a peer that stops reading doesn't hold the connection forever
+    constexpr std::chrono::seconds writeTimeout { 30 };
+    // Pause of the accept loop when the process is out of descriptors or memory
+    constexpr std::chrono::milliseconds acceptBackoff { 100 };
+
+    void fail(const beast::error_code& errorCode,
+              std::string_view what)
+    {
+        if (asio::error::eof == errorCode || asio::error::operation_aborted == errorCode)
+            return;
+        std::cerr << what << ": " << errorCode.message() << "\n";
+    }
+
+    // asio::error::timed_out when nothing arrives in time
+    asio::awaitable<std::tuple<beast::error_code, size_t>> readSome(tcp::socket& socket,
+                                                                    beast::flat_buffer& buffer,
+                                                                    Clock::duration timeout)
+    {
+        asio::steady_timer timer { socket.get_executor(), timeout };
+        auto result = co_await (socket.async_read_some(buffer.prepare(readChunk), asio::as_tuple(asio::use_awaitable)) ||
+                                timer.async_wait(asio::as_tuple(asio::use_awaitable)));
+        if (1 == result.index())
+            co_return std::tuple { beast::error_code { asio::error::timed_out }, size_t { 0 } };
+        co_return std::get<0>(std::move(result));
+    }
+}
+
+namespace Http2Server
+{
+    enum class FrameType : uint8_t
+    {
+        Data = 0x0,
+        Headers = 0x1,
+        Priority = 0x2,
+        RstStream = 0x3,
+        Settings = 0x4,
+        PushPromise = 0x5,
+        Ping = 0x6,
+        GoAway = 0x7,
+        WindowUpdate = 0x8,
+        Continuation = 0x9,
+    };
+
+    namespace Flags
+    {
+        constexpr uint8_t endStream { 0x1 };
+        constexpr uint8_t ack { 0x1 };
+        constexpr uint8_t endHeaders { 0x4 };
+        constexpr uint8_t padded { 0x8 };
+        constexpr uint8_t priority { 0x20 };
+    }
+
+    enum class Setting : uint16_t
+    {
+        HeaderTableSize = 0x1,
+        EnablePush = 0x2,
+        MaxConcurrentStreams = 0x3,
+        InitialWindowSize = 0x4,
+        MaxFrameSize = 0x5,
+        MaxHeaderListSize = 0x6,
+    };
+
+    enum class ErrorCode : uint32_t
+    {
+        NoError = 0x0,
+        ProtocolError = 0x1,
+        InternalError = 0x2,
+        FlowControlError = 0x3,
+        StreamClosed = 0x5,
+        FrameSizeError = 0x6,
+        RefusedStream = 0x7,
+        Cancel = 0x8,
+        CompressionError = 0x9,
+        EnhanceYourCalm = 0xB,
+    };
+
+    struct FrameHeader
+    {
+        uint32_t length { 0 };
+        FrameType type { FrameType::Data };
+        uint8_t flags { 0 };
+        uint32_t streamId { 0 };
+    };
+
+    uint32_t readUint32(const uint8_t* data) noexcept
+    {
+        return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | data[3];
+    }
+
+    void appendUint32(std::string& output, uint32_t value)
+    {
+        const char bytes[] { char(value >> 24), char(value >> 16), char(value >> 8), char(value) };
+        output.append(bytes, sizeof(bytes));
+    }
+
+    FrameHeader parseFrameHeader(const uint8_t* data) noexcept
+    {
+        return FrameHeader {
+            .length = (uint32_t(data[0]) << 16) | (uint32_t(data[1]) << 8) | data[2],
+            .type = static_cast<FrameType>(data[3]),
+            .flags = data[4],
+            .streamId = readUint32(data + 5) & 0x7FFF'FFFF
+        };
+    }
+
+    void appendFrame(std::string& output,
+                     FrameType type,
+                     uint8_t flags,
+                     uint32_t streamId,
+                     std::string_view payload = {})
+    {
+        const size_t length = payload.size();
+        const char header[] { char(length >> 16), char(length >> 8), char(length), char(type), char(flags) };
+        output.append(header, sizeof(header));
+        appendUint32(output, streamId & 0x7FFF'FFFF);
+        output.append(payload);
+    }
+
+    void appendSetting(std::string& output,
+                       Setting setting,
+                       uint32_t value)
+    {
+        output.push_back(char(static_cast<uint16_t>(setting) >> 8));
+        output.push_back(char(static_cast<uint16_t>(setting)));
+        appendUint32(output, value);
+    }
+
+    std::string_view asString(std::span<const uint8_t> data) noexcept
+    {
+        return { reinterpret_cast<const char*>(data.data()), data.size() };
+    }
+
+    // Removes the Pad Length field and the padding of a PADDED frame
+    bool stripPadding(const FrameHeader& frame,
+                      std::span<const uint8_t>& payload) noexcept
+    {
+        if (0 == (frame.flags & Flags::padded))
+            return true;
+        if (payload.empty() || payload.front() >= payload.size())
+            return false;
+        payload = payload.subspan(1, payload.size() - 1 - payload.front());
+        return true;
+    }
+
+    // One h2c connection. The reader and the writer are two coroutines of one strand, so there is no locking:
+    // frame handlers append to `outbound` and the writer sends everything queued in a single write.
+    class Connection
+    {
+        struct Stream
+        {
+            Hpack::HeaderList headers;
+            std::string requestBody;
+            bool requestComplete { false };
+            // Answered with 431 once the request is complete
+            bool headersTooLarge { false };
+
+            // Response body, sent as DATA frames as flow-control windows allow
+            std::string responseBody;
+            size_t sent { 0 };
+            bool responding { false };
+            int64_t sendWindow { defaultWindow };
+        };
+
+        tcp::socket socket;
+        std::string_view docRoot;
+        beast::flat_buffer input;
+
+        std::string outbound;
+        asio::steady_timer writeSignal;
+        asio::steady_timer drained;
+
+        std::map<uint32_t, Stream> streams;
+        Hpack::Decoder decoder { maxHeaderListSize };
+        Hpack::Encoder encoder;
+
+        int64_t connectionSendWindow { defaultWindow };
+        int64_t peerInitialWindow { defaultWindow };
+        uint32_t peerMaxFrameSize { maxFrameSize };
+        uint32_t lastStreamId { 0 };
+
+        // Header block being assembled from HEADERS and CONTINUATION frames
+        std::string headerBlock;
+        uint32_t headerStreamId { 0 };
+        bool headerEndStream { false };
+        bool expectContinuation { false };
+
+        bool peerGoingAway { false };
+        bool closing { false };
+        // Frames are on their way to the peer: a quiet reader is not an idle connection then
+        bool writing { false };
+
+    public:
+        Connection(tcp::socket socket,
+                   std::string_view docRoot,
+                   beast::flat_buffer input):
+            socket { std::move(socket) }, docRoot { docRoot }, input { std::move(input) },
+            writeSignal { this->socket.get_executor(), asio::steady_timer::time_point::max() },
+            drained { this->socket.get_executor(), asio::steady_timer::time_point::max() } {
+        }
+
+        asio::awaitable<void> run()
+        {
+            // Server preface. Everything but the stream and header list limits keeps its default value.
+            std::string settings;
+            appendSetting(settings, Setting::MaxConcurrentStreams, maxConcurrentStreams);
+            appendSetting(settings, Setting::MaxHeaderListSize, maxHeaderListSize);
+            appendFrame(outbound, FrameType::Settings, 0, 0, settings);
+
+            co_await (readLoop() && writeLoop());
+
+            beast::error_code ignored;
+            socket.shutdown(tcp::socket::shutdown_both, ignored);
+        }
+
+    private:
+        void signalWriter()
+        {
+            writeSignal.cancel();
+        }
+
+        asio::awaitable<void> readLoop()
+        {
+            while (!closing)
+            {
+                while (input.size() >= frameHeaderSize && !closing)
+                {
+                    const auto* data = static_cast<const uint8_t*>(input.data().data());
+                    const FrameHeader frame = parseFrameHeader(data);
+                    if (frame.length > maxFrameSize) {
+                        goAway(ErrorCode::FrameSizeError);
+                        break;
+                    }
+                    if (input.size() < frameHeaderSize + frame.length)
+                        break;
+
+                    processFrame(frame, { data + frameHeaderSize, frame.length });
+                    input.consume(frameHeaderSize + frame.length);
+                }
+                signalWriter();
+
+                // Back-pressure: stop reading while the peer does not drain what is already queued
+                while (outbound.size() >= outboundLimit && !closing)
+                    co_await drained.async_wait(asio::as_tuple);
+                if (closing)
+                    break;
+
+                const auto [errorCode, bytesRead] = co_await readSome(socket, input, idleTimeout);
+                if (asio::error::timed_out == errorCode)
+                {
+                    if (!writing) {
+                        goAway(ErrorCode::NoError);
+                        break;
+                    }
+                    continue;
+                }
+                if (errorCode) {
+                    fail(errorCode, "read");
+                    break;
+                }
+                input.commit(bytesRead);
+            }
+            closing = true;
+            signalWriter();
+        }
+
+        asio::awaitable<void> writeLoop()
+        {
+            std::string frames;
+            asio::steady_timer timer { socket.get_executor() };
+            while (true)
+            {
+                if (outbound.empty())
+                {
+                    if (closing)
+                        break;
+                    co_await writeSignal.async_wait(asio::as_tuple);
+                    continue;
+                }
+
+                std::swap(frames, outbound);
+                writing = true;
+                timer.expires_after(writeTimeout);
+                const auto written = co_await (asio::async_write(socket, asio::buffer(frames), asio::as_tuple(asio::use_awaitable)) ||
+                                               timer.async_wait(asio::as_tuple(asio::use_awaitable)));
+                writing = false;
+                frames.clear();
+
+                const beast::error_code errorCode = 0 == written.index() ? std::get<0>(std::get<0>(written))
+                                                                         : beast::error_code { asio::error::timed_out };
+                if (errorCode)
+                {
+                    fail(errorCode, "write");
+                    closing = true;
+                    socket.cancel();
+                    break;
+                }
+
+                flushData();
+                drained.cancel();
+            }
+            drained.cancel();
+        }
+
+        void goAway(ErrorCode errorCode)
+        {
+            if (closing)
+                return;
+            std::string payload;
+            appendUint32(payload, lastStreamId);
+            appendUint32(payload, static_cast<uint32_t>(errorCode));
+            appendFrame(outbound, FrameType::GoAway, 0, 0, payload);
+            closing = true;
+        }
+
+        void resetStream(uint32_t streamId,
+                         ErrorCode errorCode)
+        {
+            std::string payload;
+            appendUint32(payload, static_cast<uint32_t>(errorCode));
+            appendFrame(outbound, FrameType::RstStream, 0, streamId, payload);
+            streams.erase(streamId);
+        }
+
+        void processFrame(const FrameHeader& frame,
+                          std::span<const uint8_t> payload)
+        {
+            // A header block must not be interleaved with any other frame
+            if (expectContinuation && (FrameType::Continuation != frame.type || frame.streamId != headerStreamId))
+                return goAway(ErrorCode::ProtocolError);
+
+            switch (frame.type)
+            {
+                case FrameType::Data:
+                    return onData(frame, payload);
+                case FrameType::Headers:
+                    return onHeaders(frame, payload);
+                case FrameType::Priority:
+                    // Prioritization is advisory, streams are served in id order
+                    return 0 == frame.streamId ? goAway(ErrorCode::ProtocolError) : void();
+                case FrameType::RstStream:
+                    return onRstStream(frame, payload);
+                case FrameType::Settings:
+                    return onSettings(frame, payload);
+                case FrameType::PushPromise:
+                    // Clients never push
+                    return goAway(ErrorCode::ProtocolError);
+                case FrameType::Ping:
+                    return onPing(frame, payload);
+                case FrameType::GoAway:
+                    // Finish the streams in progress, accept no new ones
+                    peerGoingAway = true;
+                    return;
+                case FrameType::WindowUpdate:
+                    return onWindowUpdate(frame, payload);
+                case FrameType::Continuation:
+                    return onContinuation(frame, payload);
+                default:
+                    // Unknown frame types must be ignored
+                    return;
+            }
+        }
+
+        void onHeaders(const FrameHeader& frame,
+                       std::span<const uint8_t> payload)
+        {
+            if (0 == frame.streamId || 0 == (frame.streamId & 1) || !stripPadding(frame, payload))
+                return goAway(ErrorCode::ProtocolError);
+            if (frame.flags & Flags::priority)
+            {
+                if (payload.size() < 5)
+                    return goAway(ErrorCode::FrameSizeError);
+                payload = payload.subspan(5);
+            }
+
+            if (const auto stream = streams.find(frame.streamId); streams.end() == stream)
+            {
+                if (frame.streamId <= lastStreamId)
+                    return goAway(ErrorCode::StreamClosed);
+                lastStreamId = frame.streamId;
+            }
+            else if (stream->second.requestComplete)
+            {
+                return goAway(ErrorCode::StreamClosed);
+            }
+
+            headerBlock.assign(asString(payload));
+            headerStreamId = frame.streamId;
+            headerEndStream = 0 != (frame.flags & Flags::endStream);
+            expectContinuation = 0 == (frame.flags & Flags::endHeaders);
+            if (!expectContinuation)
+                finishHeaders();
+        }
+
+        void onContinuation(const FrameHeader& frame,
+                            std::span<const uint8_t> payload)
+        {
+            if (!expectContinuation)
+                return goAway(ErrorCode::ProtocolError);
+            if (headerBlock.size() + payload.size() > headerBlockLimit)
+                return goAway(ErrorCode::EnhanceYourCalm);
+
+            headerBlock.append(asString(payload));
+            expectContinuation = 0 == (frame.flags & Flags::endHeaders);
+            if (!expectContinuation)
+                finishHeaders();
+        }
+
+        void finishHeaders()
+        {
+            // Decode even when the stream is refused: the HPACK state is shared by the whole connection
+            Hpack::HeaderList headers;
+            const auto* block = reinterpret_cast<const uint8_t*>(headerBlock.data());
+            const Hpack::DecodeResult result = decoder.decode({ block, headerBlock.size() }, headers);
+            if (Hpack::DecodeResult::CompressionError == result)
+                return goAway(ErrorCode::CompressionError);
+            headerBlock.clear();
+
+            auto stream = streams.find(headerStreamId);
+            if (streams.end() == stream)
+            {
+                if (peerGoingAway || streams.size() >= maxConcurrentStreams)
+                    return resetStream(headerStreamId, ErrorCode::RefusedStream);
+                stream = streams.emplace(headerStreamId, Stream { .sendWindow = peerInitialWindow }).first;
+                stream->second.headers = std::move(headers);
+                stream->second.headersTooLarge = Hpack::DecodeResult::HeaderListTooLarge == result;
+            }
+            else if (!headerEndStream)
+            {
+                // Trailers, which must close the stream
+                return resetStream(headerStreamId, ErrorCode::ProtocolError);
+            }
+
+            if (headerEndStream)
+                dispatch(stream->first, stream->second);
+        }
+
+        void onData(const FrameHeader& frame,
+                    std::span<const uint8_t> payload)
+        {
+            if (0 == frame.streamId)
+                return goAway(ErrorCode::ProtocolError);
+
+            // The whole payload counts against flow control, padding included.
+            // The request is consumed at once, so the credit is returned right away.
+            if (frame.length > 0) {
+                std::string increment;
+                appendUint32(increment, frame.length);
+                appendFrame(outbound, FrameType::WindowUpdate, 0, 0, increment);
+            }
+
+            const auto stream = streams.find(frame.streamId);
+            if (streams.end() == stream || stream->second.requestComplete)
+            {
+                if (frame.streamId > lastStreamId)
+                    return goAway(ErrorCode::ProtocolError);
+                return resetStream(frame.streamId, ErrorCode::StreamClosed);
+            }
+            if (!stripPadding(frame, payload))
+                return goAway(ErrorCode::ProtocolError);
+
+            Stream& state = stream->second;
+            if (state.requestBody.size() + payload.size() > requestBodyLimit)
+                return resetStream(frame.streamId, ErrorCode::Cancel);
+            state.requestBody.append(asString(payload));
+
+            if (frame.flags & Flags::endStream) {
+                dispatch(stream->first, state);
+            } else if (frame.length > 0) {
+                std::string increment;
+                appendUint32(increment, frame.length);
+                appendFrame(outbound, FrameType::WindowUpdate, 0, frame.streamId, increment);
+            }
+        }
+
+        void onRstStream(const FrameHeader& frame,
+                         std::span<const uint8_t> payload)
+        {
+            if (0 == frame.streamId)
+                return goAway(ErrorCode::ProtocolError);
+            if (4 != payload.size())
+                return goAway(ErrorCode::FrameSizeError);
+            streams.erase(frame.streamId);
+        }
+
+        void onSettings(const FrameHeader& frame,
+                        std::span<const uint8_t> payload)
+        {
+            if (0 != frame.streamId)
+                return goAway(ErrorCode::ProtocolError);
+            if (frame.flags & Flags::ack)
+                return payload.empty() ? void() : goAway(ErrorCode::FrameSizeError);
+            if (0 != payload.size() % 6)
+                return goAway(ErrorCode::FrameSizeError);
+
+            for (; !payload.empty(); payload = payload.subspan(6))
+            {
+                const auto setting = static_cast<Setting>((uint16_t(payload[0]) << 8) | payload[1]);
+                const uint32_t value = readUint32(payload.data() + 2);
+                switch (setting)
+                {
+                    case Setting::InitialWindowSize:
+                    {
+                        if (value > maxWindow)
+                            return goAway(ErrorCode::FlowControlError);
+                        // Applies retroactively to every open stream
+                        const int64_t delta = int64_t(value) - peerInitialWindow;
+                        for (auto& [_, stream]: streams)
+                            if ((stream.sendWindow += delta) > maxWindow)
+                                return goAway(ErrorCode::FlowControlError);
+                        peerInitialWindow = value;
+                        break;
+                    }
+                    case Setting::MaxFrameSize:
+                        if (value < 16'384 || value > 16'777'215)
+                            return goAway(ErrorCode::ProtocolError);
+                        peerMaxFrameSize = value;
+                        break;
+                    case Setting::EnablePush:
+                        if (value > 1)
+                            return goAway(ErrorCode::ProtocolError);
+                        break;
+                    default:
+                        // The encoder never uses the dynamic table and we never open streams
+                        break;
+                }
+            }
+
+            appendFrame(outbound, FrameType::Settings, Flags::ack, 0);
+            flushData();
+        }
+
+        void onPing(const FrameHeader& frame,
+                    std::span<const uint8_t> payload)
+        {
+            if (0 != frame.streamId)
+                return goAway(ErrorCode::ProtocolError);
+            if (8 != payload.size())
+                return goAway(ErrorCode::FrameSizeError);
+            if (0 == (frame.flags & Flags::ack))
+                appendFrame(outbound, FrameType::Ping, Flags::ack, 0, asString(payload));
+        }
+
+        void onWindowUpdate(const FrameHeader& frame,
+                            std::span<const uint8_t> payload)
+        {
+            if (4 != payload.size())
+                return goAway(ErrorCode::FrameSizeError);
+
+            const uint32_t increment = readUint32(payload.data()) & 0x7FFF'FFFF;
+            if (0 == frame.streamId)
+            {
+                if (0 == increment || (connectionSendWindow += increment) > maxWindow)
+                    return goAway(0 == increment ? ErrorCode::ProtocolError : ErrorCode::FlowControlError);
+            }
+            else if (const auto stream = streams.find(frame.streamId); streams.end() != stream)
+            {
+                if (0 == increment)
+                    return resetStream(frame.streamId, ErrorCode::ProtocolError);
+                if ((stream->second.sendWindow += increment) > maxWindow)
+                    return resetStream(frame.streamId, ErrorCode::FlowControlError);
+            }
+            flushData();
+        }
+
+        // Translates the stream into an HTTP/1.1 request message, so the very same handle_request() serves it
+        void dispatch(uint32_t streamId,
+                      Stream& stream)
+        {
+            stream.requestComplete = true;
+
+            if (stream.headersTooLarge)
+            {
+                http::response<http::string_body> response { http::status::request_header_fields_too_large, 11 };
+                response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+                response.set(http::field::content_type, "text/html");
+                response.body() = "Request header fields too large";
+                response.prepare_payload();
+                return respond(streamId, stream, std::move(response), false);
+            }
+
+            http::request<http::string_body> request;
+            request.version(11);
+            for (const Hpack::HeaderField& field: stream.headers)
+            {
+                if (":method" == field.name)
+                    request.method_string(field.value);
+                else if (":path" == field.name)
+                    request.target(field.value);
+                else if (":authority" == field.name)
+                    request.set(http::field::host, field.value);
+                else if (!field.name.starts_with(':'))
+                    request.insert(field.name, field.value);
+            }
+            stream.headers.clear();
+            if (request.target().empty() || request.method_string().empty())
+                return resetStream(streamId, ErrorCode::ProtocolError);
+
+            const bool headRequest = http::verb::head == request.method();
+            request.body() = std::move(stream.requestBody);
+            request.prepare_payload();
+
+            respond(streamId, stream, handle_request(docRoot, std::move(request)), headRequest);
+        }
+
+        void respond(uint32_t streamId,
+                     Stream& stream,
+                     http::message_generator message,
+                     bool headRequest)
+        {
+            // The handler produces an HTTP/1.1 message: parse its serialized form back into header and body
+            http::response_parser<http::string_body> parser;
+            parser.eager(true);
+            parser.skip(headRequest);
+            parser.body_limit(boost::none);
+
+            beast::flat_buffer staging;
+            beast::error_code errorCode;
+            while (!parser.is_done())
+            {
+                const auto buffers = message.prepare(errorCode);
+                if (errorCode || 0 == beast::buffer_bytes(buffers))
+                    break;
+                const size_t size = asio::buffer_copy(staging.prepare(beast::buffer_bytes(buffers)), buffers);
+                staging.commit(size);
+                message.consume(size);
+
+                staging.consume(parser.put(staging.data(), errorCode));
+                if (http::error::need_more == errorCode)
+                    errorCode = {};
+                if (errorCode)
+                    break;
+            }
+            if (errorCode || !parser.is_done())
+                return resetStream(streamId, ErrorCode::InternalError);
+
+            http::response<http::string_body> response = parser.release();
+            std::string block;
+            encoder.encode(":status", std::to_string(response.result_int()), block);
+            for (const auto& field: response)
+            {
+                switch (field.name())
+                {
+                    // Connection-specific fields are not allowed in HTTP/2
+                    case http::field::connection:
+                    case http::field::keep_alive:
+                    case http::field::proxy_connection:
+                    case http::field::transfer_encoding:
+                    case http::field::upgrade:
+                        continue;
+                    default:
+                        break;
+                }
+                std::string name { std::string_view { field.name_string() } };
+                std::ranges::transform(name, name.begin(), [](unsigned char c) { return std::tolower(c); });
+                encoder.encode(name, std::string_view { field.value() }, block);
+            }
+
+            const bool endStream = response.body().empty();
+            appendHeaderBlock(streamId, block, endStream);
+            if (endStream) {
+                streams.erase(streamId);
+                return;
+            }
+
+            stream.responseBody = std::move(response.body());
+            stream.responding = true;
+            flushData();
+        }
+
+        void appendHeaderBlock(uint32_t streamId,
+                               std::string_view block,
+                               bool endStream)
+        {
+            FrameType type = FrameType::Headers;
+            uint8_t flags = endStream ? Flags::endStream : 0;
+            do {
+                const std::string_view fragment = block.substr(0, peerMaxFrameSize);
+                block.remove_prefix(fragment.size());
+                appendFrame(outbound, type, flags | (block.empty() ? Flags::endHeaders : 0), streamId, fragment);
+                type = FrameType::Continuation;
+                flags = 0;
+            } while (!block.empty());
+        }
+
+        // Queues DATA frames while both windows allow, one frame per stream per pass so streams interleave
+        void flushData()
+        {
+            bool progress = true;
+            while (progress && connectionSendWindow > 0 && outbound.size() < outboundLimit)
+            {
+                progress = false;
+                for (auto entry = streams.begin(); streams.end() != entry && connectionSendWindow > 0;)
+                {
+                    Stream& stream = entry->second;
+                    if (!stream.responding || stream.sendWindow <= 0) {
+                        ++entry;
+                        continue;
+                    }
+
+                    const size_t remaining = stream.responseBody.size() - stream.sent;
+                    const size_t chunk = std::min({ remaining, size_t(stream.sendWindow),
+                                                    size_t(connectionSendWindow), size_t(peerMaxFrameSize) });
+                    const bool last = chunk == remaining;
+                    appendFrame(outbound, FrameType::Data, last ? Flags::endStream : 0, entry->first,
+                                std::string_view { stream.responseBody }.substr(stream.sent, chunk));
+                    stream.sent += chunk;
+                    stream.sendWindow -= int64_t(chunk);
+                    connectionSendWindow -= int64_t(chunk);
+                    progress = true;
+
+                    entry = last ? streams.erase(entry) : std::next(entry);
+                }
+            }
+            signalWriter();
+        }
+    };
+
+    asio::awaitable<void> http1_session(tcp::socket socket,
+                                        beast::flat_buffer buffer,
+                                        std::string_view docRoot)
+    {
+        beast::tcp_stream stream { std::move(socket) };
+        while (true)
+        {
+            http::request_parser<http::string_body> parser;
+            parser.body_limit(requestBodyLimit);
+
+            stream.expires_after(http1Timeout);
+            const auto [readError, bytesRead] = co_await http::async_read(stream, buffer, parser, asio::as_tuple);
+            if (http::error::end_of_stream == readError)
+                break;
+            if (readError) {
+                fail(readError, "read");
+                co_return;
+            }
+
+            http::message_generator message = handle_request(docRoot, parser.release());
+            const bool keepAlive = message.keep_alive();
+            const auto [writeError, bytesWritten] = co_await beast::async_write(stream, std::move(message), asio::as_tuple);
+            if (writeError) {
+                fail(writeError, "write");
+                co_return;
+            }
+            if (!keepAlive)
+                break;
+        }
+
+        beast::error_code ignored;
+        stream.socket().shutdown(tcp::socket::shutdown_send, ignored);
+    }
+
+    // Prior knowledge: an HTTP/2 client starts with the connection preface, anything else is served as HTTP/1.1
+    asio::awaitable<void> session(tcp::socket socket,
+                                  std::string_view docRoot)
+    {
+        socket.set_option(tcp::no_delay { true });
+
+        beast::flat_buffer buffer;
+        const auto received = [&buffer] {
+            return std::string_view { static_cast<const char*>(buffer.data().data()), buffer.size() };
+        };
+        const Clock::time_point deadline = Clock::now() + prefaceTimeout;
+        while (buffer.size() < clientPreface.size() && clientPreface.starts_with(received()))
+        {
+            const auto [errorCode, bytesRead] = co_await readSome(socket, buffer, deadline - Clock::now());
+            if (errorCode) {
+                fail(errorCode, "read_preface");
+                co_return;
+            }
+            buffer.commit(bytesRead);
+        }
+
+        if (received().starts_with(clientPreface))
+        {
+            buffer.consume(clientPreface.size());
+            Connection connection { std::move(socket), docRoot, std::move(buffer) };
+            co_await connection.run();
+        }
+        else
+        {
+            co_await http1_session(std::move(socket), std::move(buffer), docRoot);
+        }
+    }
+
+    asio::awaitable<void> listen(tcp::acceptor acceptor,
+                                 std::string_view docRoot)
+    {
+        const asio::any_io_executor executor = co_await asio::this_coro::executor;
+        asio::steady_timer backoff { executor };
+        while (true)
+        {
+            auto [errorCode, socket] = co_await acceptor.async_accept(asio::as_tuple);
+            if (errorCode)
+            {
+                fail(errorCode, "accept");
+                if (asio::error::connection_aborted == errorCode)
+                    continue;
+                // Out of descriptors or memory: the pending connection stays queued, retrying at once would spin
+                if (asio::error::no_descriptors == errorCode || asio::error::no_buffer_space == errorCode ||
+                    asio::error::no_memory == errorCode ||
+                    boost::system::errc::too_many_files_open_in_system == errorCode)
+                {
+                    backoff.expires_after(acceptBackoff);
+                    co_await backoff.async_wait(asio::as_tuple);
+                    continue;
+                }
+                // The acceptor itself is broken or closed
+                co_return;
+            }
+            // A strand per connection: its reader and writer may never run concurrently
+            asio::co_spawn(asio::make_strand(executor), session(std::move(socket), docRoot), asio::detached);
+        }
+    }
+
+    int runServer()
+    {
+        constexpr uint32_t threads { 4 };
+
+        try
+        {
+            asio::io_context ioc { threads };
+            tcp::acceptor acceptor { ioc, { ip::make_address(host), port } };
+            asio::co_spawn(ioc, listen(std::move(acceptor), docRoot), [](std::exception_ptr e) {
+                if (e) {
+                    std::rethrow_exception(e);
+                }
+            });
+
+            std::vector<std::jthread> runners;
+            runners.reserve(threads - 1);
+            for (uint32_t i = 1; i < threads; ++i)
+                runners.emplace_back([&ioc] { ioc.run(); });
+            ioc.run();
+
+            return EXIT_SUCCESS;
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+}
+
+namespace Http2Server::Benchmark
+{
+    constexpr size_t totalRequests { 20'480 };
+    constexpr size_t concurrency { 64 };
+    constexpr size_t fileSize { 4 * 1024 };
+    constexpr std::string_view target { "/index.html" };
+    constexpr std::string_view benchmarkRoot { "/tmp/h2_benchmark" };
+
+    // Multiplexes every request over one connection, `concurrency` streams in flight
+    asio::awaitable<size_t> http2_client(tcp::endpoint endpoint,
+                                         size_t requests)
+    {
+        tcp::socket socket { co_await asio::this_coro::executor };
+        co_await socket.async_connect(endpoint);
+        socket.set_option(tcp::no_delay { true });
+
+        // Maximum windows: the benchmark measures the server, not WINDOW_UPDATE round trips
+        std::string output { clientPreface };
+        std::string payload;
+        appendSetting(payload, Setting::InitialWindowSize, maxWindow);
+        appendFrame(output, FrameType::Settings, 0, 0, payload);
+        payload.clear();
+        appendUint32(payload, maxWindow - defaultWindow);
+        appendFrame(output, FrameType::WindowUpdate, 0, 0, payload);
+
+        const Hpack::Encoder encoder;
+        Hpack::Decoder decoder;
+        beast::flat_buffer input;
+        uint32_t nextStreamId = 1;
+        size_t sent = 0, completed = 0, inFlight = 0, bodyBytes = 0;
+
+        while (completed < requests)
+        {
+            while (inFlight < concurrency && sent < requests)
+            {
+                std::string block;
+                encoder.encode(":method", "GET", block);
+                encoder.encode(":scheme", "http", block);
+                encoder.encode(":path", target, block);
+                encoder.encode(":authority", "localhost", block);
+                appendFrame(output, FrameType::Headers, Flags::endHeaders | Flags::endStream, nextStreamId, block);
+                nextStreamId += 2;
+                ++sent;
+                ++inFlight;
+            }
+            if (!output.empty()) {
+                co_await asio::async_write(socket, asio::buffer(output));
+                output.clear();
+            }
+
+            input.commit(co_await socket.async_read_some(input.prepare(readChunk)));
+            while (input.size() >= frameHeaderSize)
+            {
+                const auto* data = static_cast<const uint8_t*>(input.data().data());
+                const FrameHeader frame = parseFrameHeader(data);
+                if (input.size() < frameHeaderSize + frame.length)
+                    break;
+                const std::span<const uint8_t> framePayload { data + frameHeaderSize, frame.length };
+
+                switch (frame.type)
+                {
+                    case FrameType::Headers:
+                    {
+                        Hpack::HeaderList headers;
+                        if (0 == (frame.flags & Flags::endHeaders) ||
+                            Hpack::DecodeResult::Ok != decoder.decode(framePayload, headers))
+                            throw std::runtime_error("Unexpected header block");
+                        break;
+                    }
+                    case FrameType::Data:
+                        bodyBytes += frame.length;
+                        break;
+                    case FrameType::Settings:
+                        if (0 == (frame.flags & Flags::ack))
+                            appendFrame(output, FrameType::Settings, Flags::ack, 0);
+                        break;
+                    case FrameType::RstStream:
+                    case FrameType::GoAway:
+                        throw std::runtime_error("Stream reset by the server");
+                    default:
+                        break;
+                }
+                if ((FrameType::Headers == frame.type || FrameType::Data == frame.type) && (frame.flags & Flags::endStream)) {
+                    ++completed;
+                    --inFlight;
+                }
+                input.consume(frameHeaderSize + frame.length);
+            }
+        }
+        co_return bodyBytes;
+    }
+
+    // Sequential requests over one keep-alive connection: HTTP/1.1 needs a connection per request in flight
+    asio::awaitable<size_t> http1_client(tcp::endpoint endpoint,
+                                         size_t requests)
+    {
+        beast::tcp_stream stream { co_await asio::this_coro::executor };
+        co_await stream.async_connect(endpoint);
+        stream.socket().set_option(tcp::no_delay { true });
+
+        beast::flat_buffer buffer;
+        size_t bodyBytes = 0;
+        for (size_t i = 0; i < requests; ++i)
+        {
+            http::request<http::empty_body> request { http::verb::get, target, 11 };
+            request.set(http::field::host, "localhost");
+            co_await http::async_write(stream, request);
+
+            http::response<http::string_body> response;
+            co_await http::async_read(stream, buffer, response);
+            bodyBytes += response.body().size();
+        }
+        co_return bodyBytes;
+    }
+
+    void report(std::string_view name,
+                size_t connections,
+                size_t bodyBytes,
+                Clock::duration elapsed)
+    {
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        std::cout << std::format("{:<22} {:>4} connection(s)  {:>10.0f} req/s  {:>8.1f} MB/s\n", name, connections,
+                                 double(totalRequests) / seconds, double(bodyBytes) / seconds / (1024 * 1024));
+    }
+
+    void run()
+    {
+        std::filesystem::create_directories(benchmarkRoot);
+        std::ofstream { std::string(benchmarkRoot) + std::string(target) } << std::string(fileSize, 'x');
+
+        // Same process, same handle_request(): only the protocol differs between the two runs
+        asio::io_context serverContext { 1 };
+        tcp::acceptor acceptor { serverContext, { ip::make_address_v4("127.0.0.1"), 0 } };
+        const tcp::endpoint endpoint = acceptor.local_endpoint();
+        asio::co_spawn(serverContext, listen(std::move(acceptor), benchmarkRoot), asio::detached);
+        std::jthread serverThread { [&serverContext] { serverContext.run(); } };
+
+        const auto measure = [&](std::string_view name, size_t connections, auto client) {
+            asio::io_context clientContext { 1 };
+            size_t bodyBytes = 0;
+            const Clock::time_point start = Clock::now();
+            for (size_t i = 0; i < connections; ++i)
+            {
+                asio::co_spawn(clientContext, client(endpoint, totalRequests / connections),
+                               [&bodyBytes](std::exception_ptr e, size_t bytes) {
+                    if (e) {
+                        std::rethrow_exception(e);
+                    }
+                    bodyBytes += bytes;
+                });
+            }
+            clientContext.run();
+            report(name, connections, bodyBytes, Clock::now() - start);
+        };
+
+        measure("HTTP/2 multiplexed", 1, http2_client);
+        measure("HTTP/1.1 keep-alive", concurrency, http1_client);
+
+        serverContext.stop();
+    }
+}
+
+// curl --http2-prior-knowledge http://localhost:8082/index.html
+// curl http://localhost:8082/index.html
+void Http2Server::TestAll()
+{
+    runServer();
+    // Benchmark::run();
+}
@@ -0,0 +1,18 @@
+/**============================================================================
+Name        : Http2Server.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Http2Server.h
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_HTTP2SERVER_H
+#define BOOSTPROJECTS_HTTP2SERVER_H
+
+namespace Http2Server
+{
+    void TestAll();
+};
+
+#endif //BOOSTPROJECTS_HTTP2SERVER_H
@@ -0,0 +1,150 @@
+/**============================================================================
+Name        : JsonStream.cpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : HTTP response bodies parsed as JSON while they are being received
+============================================================================**/
+
+#include "JsonStream.h"
+
+#include <iostream>
+#include <format>
+#include <print>
+#include <string>
+#include <chrono>
+#include <algorithm>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/local/connect_pair.hpp>
+#include <boost/beast/version.hpp>
+
+namespace
+{
+    using namespace JsonStream;
+    using Clock = std::chrono::steady_clock;
+    using Socket = asio::local::stream_protocol::socket;
+
+    std::string makeDocument(size_t items)
+    {
+        json::array array;
+        array.reserve(items);
+        for (size_t i = 0; i < items; ++i) {
+            array.push_back(json::object {
+                { "id", i },
+                { "name", std::format("item-{}", i) },
+                { "price", double(i) * 0.25 },
+                { "tags", json::array { "red", "green", "blue" } }
+            });
+        }
+        return json::serialize(array);
+    }
+
+    // Stands for the server: a chunked response written as many transfer chunks, with the reader given a turn
+    // after each one. The pieces are not aligned on JSON tokens or on Options::chunkSize, so the parser is fed
+    // across chunk boundaries.
+    asio::awaitable<void> serve(Socket& socket,
+                                const std::string& document)
+    {
+        constexpr size_t pieceSize { 10'000 };
+
+        http::response<http::empty_body> response { http::status::ok, 11 };
+        response.set(http::field::content_type, "application/json");
+        response.chunked(true);
+        http::response_serializer<http::empty_body> serializer { response };
+        co_await http::async_write_header(socket, serializer, asio::use_awaitable);
+
+        const asio::any_io_executor executor = co_await asio::this_coro::executor;
+        for (size_t offset = 0; offset < document.size(); offset += pieceSize)
+        {
+            const size_t size = std::min(pieceSize, document.size() - offset);
+            co_await asio::async_write(socket, http::make_chunk(asio::buffer(document.data() + offset, size)),
+                                       asio::use_awaitable);
+            co_await asio::post(executor, asio::use_awaitable);
+        }
+        co_await asio::async_write(socket, http::make_chunk_last(), asio::use_awaitable);
+    }
+
+    // The way the clients do it today: the whole body first, then the parse
+    asio::awaitable<json::value> readBuffered(Socket& socket)
+    {
+        beast::flat_buffer buffer;
+        http::response_parser<http::string_body> parser;
+        parser.body_limit(boost::none);
+        co_await http::async_read(socket, buffer, parser, asio::use_awaitable);
+        co_return json::parse(parser.get().body());
+    }
+}
+
+namespace JsonStream
+{
+    asio::awaitable<Result> fetch(ConnectionPool::Pool& pool,
+                                  const ConnectionPool::Origin& origin,
+                                  ConnectionPool::Request request,
+                                  Options options)
+    {
+        request.set(http::field::host, origin.host);
+        request.set(http::field::accept, "application/json");
+        if (!request.has(http::field::user_agent))
+            request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+        request.keep_alive(true);
+        request.prepare_payload();
+        options.head = http::verb::head == request.method();
+
+        // A failure in the middle of the body leaves the lease unreleased: the connection is closed
+        ConnectionPool::Lease lease = co_await pool.acquire(origin);
+        ConnectionPool::Connection& connection = *lease;
+
+        beast::get_lowest_layer(connection.stream).expires_after(std::chrono::seconds(30u));
+        co_await http::async_write(connection.stream, request);
+        Result result = co_await read(connection.stream, connection.buffer, options);
+
+        beast::get_lowest_layer(connection.stream).expires_never();
+        ++connection.requests;
+        lease.release(result.keepAlive);
+        co_return result;
+    }
+}
+
+// A 100 000 element document over a local socket pair: buffered parse vs parse while receiving
+void JsonStream::TestAll()
+{
+    using namespace std::chrono_literals;
+    const std::string document = makeDocument(100'000);
+
+    asio::io_context ioCtx;
+    const auto run = [&](std::string_view name,
+                         auto&& client) {
+        Socket server { ioCtx }, socket { ioCtx };
+        asio::local::connect_pair(server, socket);
+
+        const Clock::time_point start = Clock::now();
+        asio::co_spawn(ioCtx, serve(server, document), asio::detached);
+        asio::co_spawn(ioCtx, client(socket), [&](const std::exception_ptr& exc) {
+            if (exc)
+                std::rethrow_exception(exc);
+            std::println("{:<10} {:.2f} MB in {} us", name, double(document.size()) / (1024 * 1024),
+                         (Clock::now() - start) / 1us);
+        });
+        ioCtx.run();
+        ioCtx.restart();
+    };
+
+    run("buffered", [](Socket& socket) -> asio::awaitable<void> {
+        const json::value value = co_await readBuffered(socket);
+        std::println("{:<10} {} items, whole body held in memory", "", value.as_array().size());
+    });
+    run("streamed", [](Socket& socket) -> asio::awaitable<void> {
+        beast::flat_buffer buffer;
+        const Result result = co_await read(socket, buffer);
+        std::println("{:<10} {} items, {} chunks of at most {} bytes", "", result.value.as_array().size(),
+                     result.chunks, Options {}.chunkSize);
+    });
+}
@@ -0,0 +1,118 @@
+/**============================================================================
+Name        : JsonStream.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : HTTP response bodies parsed as JSON while they are being received
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_JSONSTREAM_H
+#define BOOSTPROJECTS_JSONSTREAM_H
+
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/as_tuple.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/json.hpp>
+#include <boost/system/system_error.hpp>
+
+#include "ConnectionPool.h"
+
+namespace JsonStream
+{
+    namespace asio = boost::asio;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    namespace json = boost::json;
+
+    struct Options
+    {
+        // Body bytes handed to the JSON parser at once: the only raw body memory held
+        size_t chunkSize { 64 * 1024 };
+        uint64_t bodyLimit { 64 * 1024 * 1024 };
+        json::parse_options parse {};
+        // The response answers a HEAD request: no body follows its header
+        bool head { false };
+    };
+
+    struct Result
+    {
+        unsigned status { 0 };
+        // Null unless the response is a 2xx with a non-empty JSON body
+        json::value value;
+        uint64_t bodyBytes { 0 };
+        size_t chunks { 0 };
+        bool keepAlive { false };
+    };
+
+    // application/json or a structured syntax suffix such as application/problem+json, parameters ignored
+    inline bool isJson(std::string_view contentType) noexcept
+    {
+        std::string_view type = contentType.substr(0, contentType.find(';'));
+        while (!type.empty() && (' ' == type.back() || '\t' == type.back()))
+            type.remove_suffix(1);
+        constexpr std::string_view suffix { "+json" };
+        return beast::iequals(type, "application/json")
+               || (type.size() > suffix.size() && beast::iequals(type.substr(type.size() - suffix.size()), suffix));
+    }
+
+    // Reads a response from `stream` and parses its body chunk by chunk as it arrives, instead of
+    // buffering it whole and parsing it afterwards. Any other body (an error page, a 204, no body at all)
+    // is read and dropped, the status tells why. Throws on I/O errors and on invalid JSON.
+    template <typename Stream>
+    asio::awaitable<Result> read(Stream& stream,
+                                 beast::flat_buffer& buffer,
+                                 Options options = {},
+                                 json::storage_ptr storage = {})
+    {
+        http::response_parser<http::buffer_body> parser;
+        parser.body_limit(options.bodyLimit);
+        parser.skip(options.head);
+        co_await http::async_read_header(stream, buffer, parser);
+
+        Result result { .status = parser.get().result_int() };
+        const bool parse = 2 == result.status / 100 && isJson(parser.get()[http::field::content_type]);
+        json::stream_parser jsonParser { std::move(storage), options.parse };
+        std::vector<char> chunk(options.chunkSize);
+        while (!parser.is_done())
+        {
+            http::buffer_body::value_type& body = parser.get().body();
+            body.data = chunk.data();
+            body.size = chunk.size();
+
+            // need_buffer: the chunk is full, not an error
+            const auto [errorCode, bytesRead] = co_await http::async_read(stream, buffer, parser, asio::as_tuple);
+            if (errorCode && http::error::need_buffer != errorCode)
+                throw boost::system::system_error(errorCode, "read body");
+
+            if (const size_t filled = chunk.size() - body.size; filled > 0) {
+                if (parse)
+                    jsonParser.write(chunk.data(), filled);
+                result.bodyBytes += filled;
+                ++result.chunks;
+            }
+        }
+
+        if (parse && result.bodyBytes > 0) {
+            jsonParser.finish();
+            result.value = jsonParser.release();
+        }
+        result.keepAlive = parser.keep_alive();
+        co_return result;
+    }
+
+    // GET (or any request) on a pooled connection, with the response body streamed into JSON
+    asio::awaitable<Result> fetch(ConnectionPool::Pool& pool,
+                                  const ConnectionPool::Origin& origin,
+                                  ConnectionPool::Request request,
+                                  Options options = {});
+
+    void TestAll();
+}
+
+#endif //BOOSTPROJECTS_JSONSTREAM_H
@@ -0,0 +1,266 @@
+/**============================================================================
+Name        : LoadBalancer.cpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Client-side load balancing over a set of HTTPS backends
+============================================================================**/
+
+#include "LoadBalancer.h"
+
+#include <iostream>
+#include <format>
+#include <print>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <stdexcept>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/as_tuple.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include "trust_store.hpp"
+
+namespace
+{
+    using namespace LoadBalancer;
+    namespace http = boost::beast::http;
+    namespace ssl = asio::ssl;
+
+    // FNV-1a with a murmur3 finalizer: FNV alone clusters similar keys ("user-1", "user-2") on the ring
+    uint64_t hashOf(std::string_view text) noexcept
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (const unsigned char c: text) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    std::minstd_rand& generator()
+    {
+        thread_local std::minstd_rand engine { std::random_device {}() };
+        return engine;
+    }
+}
+
+namespace LoadBalancer
+{
+    Balancer::Balancer(ConnectionPool::Pool& pool,
+                       const std::vector<Origin>& origins,
+                       Options options): pool { pool }, options { options }
+    {
+        if (origins.empty())
+            throw std::invalid_argument("LoadBalancer::Balancer: no backend");
+
+        backends.reserve(origins.size());
+        ring.reserve(origins.size() * options.virtualNodes);
+        for (size_t index = 0; index < origins.size(); ++index) {
+            backends.push_back(Backend { .origin = origins[index] });
+            for (size_t node = 0; node < std::max<size_t>(options.virtualNodes, 1); ++node)
+                ring.emplace_back(hashOf(std::format("{}#{}", origins[index].key(), node)), index);
+        }
+        std::ranges::sort(ring);
+    }
+
+    size_t Balancer::pickHashed(std::string_view key,
+                                Clock::time_point now) const
+    {
+        const auto availableCount = static_cast<size_t>(std::ranges::count_if(backends, [&](const Backend& backend) {
+            return available(backend, now);
+        }));
+        // Everything ejected: better a failing backend than none
+        const auto usable = [&](const Backend& backend) {
+            return 0 == availableCount || available(backend, now);
+        };
+
+        // Room for this request on a backend: a share of all outstanding requests, this one included
+        const double capacity = std::ceil(options.loadFactor * double(outstanding + 1)
+                                          / double(std::max<size_t>(availableCount, 1)));
+
+        const uint64_t hash = hashOf(key);
+        const auto first = std::ranges::lower_bound(ring, std::pair { hash, size_t { 0 } });
+        const size_t start = static_cast<size_t>(std::distance(ring.begin(), first));
+
+        size_t fallback = ring[start % ring.size()].second;
+        bool haveFallback = false;
+        for (size_t step = 0; step < ring.size(); ++step)
+        {
+            const size_t index = ring[(start + step) % ring.size()].second;
+            const Backend& backend = backends[index];
+            if (!usable(backend))
+                continue;
+            if (double(backend.outstanding + 1) <= capacity)
+                return index;
+            if (!haveFallback) {
+                fallback = index;
+                haveFallback = true;
+            }
+        }
+        return fallback;
+    }
+
+    size_t Balancer::pickTwoChoices(Clock::time_point now) const
+    {
+        std::vector<size_t> candidates;
+        candidates.reserve(backends.size());
+        for (size_t index = 0; index < backends.size(); ++index) {
+            if (available(backends[index], now))
+                candidates.push_back(index);
+        }
+        if (candidates.empty()) {
+            for (size_t index = 0; index < backends.size(); ++index)
+                candidates.push_back(index);
+        }
+        if (1 == candidates.size())
+            return candidates.front();
+
+        std::uniform_int_distribution<size_t> distribution { 0, candidates.size() - 1 };
+        const size_t first = distribution(generator());
+        size_t second = distribution(generator());
+        while (second == first)
+            second = distribution(generator());
+
+        const size_t a = candidates[first], b = candidates[second];
+        return backends[b].outstanding < backends[a].outstanding ? b : a;
+    }
+
+    size_t Balancer::acquire(std::string_view key)
+    {
+        std::lock_guard lock { mutex };
+        const Clock::time_point now = Clock::now();
+        const size_t index = Strategy::ConsistentHash == options.strategy ? pickHashed(key, now)
+                                                                          : pickTwoChoices(now);
+        ++backends[index].outstanding;
+        ++outstanding;
+        return index;
+    }
+
+    void Balancer::release(size_t index,
+                           bool success)
+    {
+        std::lock_guard lock { mutex };
+        const Clock::time_point now = Clock::now();
+        Backend& backend = backends[index];
+        --backend.outstanding;
+        --outstanding;
+        ++backend.requests;
+
+        if (success) {
+            backend.consecutiveFailures = 0;
+            backend.ejectionsInRow = 0;
+            return;
+        }
+
+        ++backend.failures;
+        if (++backend.consecutiveFailures < options.ejectAfter || !available(backend, now))
+            return;
+
+        const auto ejected = static_cast<size_t>(std::ranges::count_if(backends, [&](const Backend& other) {
+            return !available(other, now);
+        }));
+        if (double(ejected + 1) > options.maxEjectedShare * double(backends.size()))
+            return;
+
+        const Clock::duration duration = std::min(options.maxEjectionTime,
+                                                  options.ejectionTime * (1u << std::min(backend.ejectionsInRow, 16u)));
+        backend.ejectedUntil = now + duration;
+        backend.consecutiveFailures = 0;
+        ++backend.ejectionsInRow;
+        ++backend.ejections;
+    }
+
+    asio::awaitable<Response> Balancer::send(Request request,
+                                             std::string key)
+    {
+        const std::string_view target { request.target().data(), request.target().size() };
+        const size_t index = acquire(key.empty() ? target : std::string_view { key });
+        // The backends never change after construction: their origins are read without the lock
+        const Origin origin = backends[index].origin;
+
+        try {
+            Response response = co_await ConnectionPool::send(pool, origin, std::move(request));
+            release(index, response.result_int() < 500);
+            co_return response;
+        }
+        catch (...) {
+            release(index, false);
+            throw;
+        }
+    }
+
+    std::vector<BackendStats> Balancer::stats() const
+    {
+        std::lock_guard lock { mutex };
+        const Clock::time_point now = Clock::now();
+        std::vector<BackendStats> result;
+        result.reserve(backends.size());
+        for (const Backend& backend: backends) {
+            result.push_back(BackendStats {
+                .origin = backend.origin.key(),
+                .requests = backend.requests,
+                .failures = backend.failures,
+                .outstanding = backend.outstanding,
+                .ejections = backend.ejections,
+                .ejected = !available(backend, now)
+            });
+        }
+        return result;
+    }
+}
+
+// HTTPS_Server on 8443 twice (by name and by address) plus a port nobody listens on: the dead backend is
+// ejected after a few refused connections, keys keep going to the same live backend
+void LoadBalancer::TestAll()
+{
+    constexpr size_t requests { 400 };
+    constexpr size_t concurrency { 16 };
+
+    asio::io_context ioCtx;
+    ssl::context ctx { ssl::context::tlsv13_client };
+    load_shared_root_certificates(ctx);
+    ConnectionPool::Pool pool { ioCtx.get_executor(), ctx };
+    const std::vector<Origin> origins { { "127.0.0.1", 8443 }, { "localhost", 8443 }, { "127.0.0.1", 8449 } };
+
+    for (const Strategy strategy: { Strategy::ConsistentHash, Strategy::PowerOfTwoChoices })
+    {
+        Balancer balancer { pool, origins, Options { .strategy = strategy } };
+        size_t next = 0, failed = 0;
+        for (size_t worker = 0; worker < concurrency; ++worker)
+        {
+            asio::co_spawn(ioCtx, [&]() -> asio::awaitable<void> {
+                while (next < requests)
+                {
+                    // 50 distinct keys, e.g. user ids
+                    const std::string key = std::format("user-{}", next++ % 50);
+                    const auto [exc, response] = co_await asio::co_spawn(ioCtx,
+                            balancer.send(Request { http::verb::get, "/", 11 }, key),
+                            asio::as_tuple(asio::use_awaitable));
+                    if (exc)
+                        ++failed;
+                }
+            }, [](const std::exception_ptr& exc) {
+                if (exc)
+                    std::rethrow_exception(exc);
+            });
+        }
+        ioCtx.run();
+        ioCtx.restart();
+
+        std::println("{}: {} requests, {} failed", Strategy::ConsistentHash == strategy ? "consistent hash" : "P2C",
+                     requests, failed);
+        for (const BackendStats& stats: balancer.stats())
+            std::println("    {:<16} requests {:>4}, failures {:>2}, ejections {}{}", stats.origin, stats.requests,
+                         stats.failures, stats.ejections, stats.ejected ? " (ejected)" : "");
+    }
+    pool.close();
+}
@@ -0,0 +1,129 @@
+/**============================================================================
+Name        : LoadBalancer.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Client-side load balancing over a set of HTTPS backends
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_LOADBALANCER_H
+#define BOOSTPROJECTS_LOADBALANCER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <utility>
+
+#include <boost/asio/awaitable.hpp>
+
+#include "ConnectionPool.h"
+
+namespace LoadBalancer
+{
+    namespace asio = boost::asio;
+
+    using Clock = std::chrono::steady_clock;
+    using ConnectionPool::Origin;
+    using ConnectionPool::Request;
+    using ConnectionPool::Response;
+
+    enum class Strategy
+    {
+        // Same key, same backend while it has room: keeps backend caches warm
+        ConsistentHash,
+        // The less busy of two random backends: the best spread when affinity doesn't matter
+        PowerOfTwoChoices
+    };
+
+    struct Options
+    {
+        Strategy strategy { Strategy::ConsistentHash };
+        // Points of each backend on the hash ring
+        size_t virtualNodes { 100 };
+        // Bounded loads: no backend takes more than loadFactor times the average of outstanding requests
+        double loadFactor { 1.25 };
+        // Passive ejection: consecutive failures (errors or 5xx) that take a backend out of rotation
+        uint32_t ejectAfter { 5 };
+        // Doubles with every ejection in a row, up to maxEjectionTime
+        Clock::duration ejectionTime { std::chrono::seconds(10) };
+        Clock::duration maxEjectionTime { std::chrono::minutes(5) };
+        // Never more than this share of the backends ejected at the same time
+        double maxEjectedShare { 0.5 };
+    };
+
+    struct BackendStats
+    {
+        std::string origin;
+        uint64_t requests { 0 };
+        uint64_t failures { 0 };
+        size_t outstanding { 0 };
+        uint32_t ejections { 0 };
+        bool ejected { false };
+    };
+
+    class Balancer
+    {
+        struct Backend
+        {
+            Origin origin;
+            size_t outstanding { 0 };
+            uint32_t consecutiveFailures { 0 };
+            // Since the last success: sets the length of the next ejection
+            uint32_t ejectionsInRow { 0 };
+            uint32_t ejections { 0 };
+            Clock::time_point ejectedUntil {};
+            uint64_t requests { 0 };
+            uint64_t failures { 0 };
+        };
+
+        ConnectionPool::Pool& pool;
+        const Options options;
+
+        mutable std::mutex mutex;
+        std::vector<Backend> backends;
+        // Sorted virtual nodes: hash and backend index
+        std::vector<std::pair<uint64_t, size_t>> ring;
+        size_t outstanding { 0 };
+
+    public:
+        Balancer(ConnectionPool::Pool& pool,
+                 const std::vector<Origin>& origins,
+                 Options options = {});
+
+        // Sends `request` to the backend picked for `key` (the request target when empty), on a pooled
+        // connection of that backend. Failures count towards its ejection; they are not retried elsewhere.
+        asio::awaitable<Response> send(Request request,
+                                       std::string key = {});
+
+        [[nodiscard]]
+        std::vector<BackendStats> stats() const;
+
+    private:
+        // Index of the chosen backend, with its outstanding request counted
+        size_t acquire(std::string_view key);
+
+        void release(size_t index,
+                     bool success);
+
+        [[nodiscard]]
+        size_t pickHashed(std::string_view key,
+                          Clock::time_point now) const;
+
+        [[nodiscard]]
+        size_t pickTwoChoices(Clock::time_point now) const;
+
+        [[nodiscard]]
+        bool available(const Backend& backend,
+                       Clock::time_point now) const noexcept {
+            return now >= backend.ejectedUntil;
+        }
+    };
+
+    void TestAll();
+}
+
+#endif //BOOSTPROJECTS_LOADBALANCER_H
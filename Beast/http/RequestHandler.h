@@ -0,0 +1,180 @@
+/**============================================================================
+Name        : RequestHandler.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Static file request handler shared by the HTTP/1.1 and HTTP/2 servers
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_REQUESTHANDLER_H
+#define BOOSTPROJECTS_REQUESTHANDLER_H
+
+#include <string>
+#include <string_view>
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+
+namespace RequestHandler
+{
+    using namespace std::string_view_literals;
+
+    namespace beast = boost::beast;
+    namespace http  = beast::http;
+
+    constexpr std::string_view mimeType(beast::string_view path) {
+        if (path.ends_with(".htm"sv))
+            return "text/html";
+        if (path.ends_with(".html"sv))
+            return "text/html";
+        if (path.ends_with(".php"sv))
+            return "text/html";
+        if (path.ends_with(".css"sv))
+            return "text/css";
+        if (path.ends_with(".txt"sv))
+            return "text/plain";
+        if (path.ends_with(".js"sv))
+            return "application/javascript";
+        if (path.ends_with(".json"sv))
+            return "application/json";
+        if (path.ends_with(".xml"sv))
+            return "application/xml";
+        if (path.ends_with(".swf"sv))
+            return "application/x-shockwave-flash";
+        if (path.ends_with(".flv"sv))
+            return "video/x-flv";
+        if (path.ends_with(".png"sv))
+            return "image/png";
+        if (path.ends_with(".jpe"sv))
+            return "image/jpeg";
+        if (path.ends_with(".jpeg"sv))
+            return "image/jpeg";
+        if (path.ends_with(".jpg"sv))
+            return "image/jpeg";
+        if (path.ends_with(".gif"sv))
+            return "image/gif";
+        if (path.ends_with(".bmp"sv))
+            return "image/bmp";
+        if (path.ends_with(".ico"sv))
+            return "image/vnd.microsoft.icon";
+        if (path.ends_with(".tiff"sv))
+            return "image/tiff";
+        if (path.ends_with(".tif"sv))
+            return "image/tiff";
+        if (path.ends_with(".svg"sv))
+            return "image/svg+xml";
+        if (path.ends_with(".svgz"sv))
+            return "image/svg+xml";
+        return "application/text";
+    }
+
+    // Append an HTTP rel-path to a local filesystem path -> returned path is normalized for the platform.
+    inline std::string path_cat(std::string_view base,
+                         std::string_view path) {
+        if (base.empty())
+            return std::string(path);
+        std::string result(base);
+
+        constexpr char path_separator = '/';
+        if (result.back() == path_separator)
+            result.resize(result.size() - 1);
+        result.append(path.data(), path.size());
+        return result;
+    }
+
+    // Return a response for the given request.
+    // The concrete type of the response message (which depends on the request), is type-erased in message_generator.
+    template <class Body, class Allocator>
+    http::message_generator handle_request(std::string_view doc_root,
+                                           http::request<Body, http::basic_fields<Allocator>>&& request)
+    {
+        // Returns a bad request response
+        const auto bad_request = [&request](beast::string_view why) {
+            http::response<http::string_body> response { http::status::bad_request, request.version() };
+            response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+            response.set(http::field::content_type, "text/html");
+            response.keep_alive(request.keep_alive());
+            response.body() = std::string(why);
+            response.prepare_payload();
+            return response;
+        };
+
+        // Returns a not found response
+        const auto not_found = [&request](beast::string_view target) {
+            http::response<http::string_body> response { http::status::not_found, request.version() };
+            response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+            response.set(http::field::content_type, "text/html");
+            response.keep_alive(request.keep_alive());
+            response.body() = "The resource '" + std::string(target) + "' was not found.";
+            response.prepare_payload();
+            return response;
+        };
+
+        // Returns a server error response
+        const auto server_error = [&request](beast::string_view what) {
+            http::response<http::string_body> response { http::status::internal_server_error, request.version() };
+            response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+            response.set(http::field::content_type, "text/html");
+            response.keep_alive(request.keep_alive());
+            response.body() = "An error occurred: '" + std::string(what) + "'";
+            response.prepare_payload();
+            return response;
+        };
+
+        // Make sure we can handle the method
+        if (http::verb::get != request.method() && http::verb::head != request.method())
+            return bad_request("Unknown HTTP-method");
+
+        // Request path must be absolute and not contain "..".
+        if (request.target().empty() || request.target()[0] != '/' || request.target().find("..") != beast::string_view::npos)
+            return bad_request("Illegal request-target");
+
+        // Build the path to the requested file
+        std::string path = path_cat(doc_root, request.target());
+        if ('/' == request.target().back())
+            path.append("index.html");
+
+        // Attempt to open the file
+        beast::error_code errorCode;
+        http::file_body::value_type body;
+        body.open(path.c_str(), beast::file_mode::scan, errorCode);
+
+        // Handle the case where the file doesn't exist
+        if (beast::errc::no_such_file_or_directory == errorCode)
+            return not_found(request.target());
+
+        // Handle an unknown error
+        if (errorCode) {
+            return server_error(errorCode.message());
+        }
+
+        // Cache the size since we need it after the move
+        const uint64_t size = body.size();
+
+        // Respond to HEAD request
+        if (request.method() == http::verb::head)
+        {
+            http::response<http::empty_body> res{http::status::ok, request.version()};
+            res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+            res.set(http::field::content_type, mimeType(path));
+            res.content_length(size);
+            res.keep_alive(request.keep_alive());
+            return res;
+        }
+
+        // Respond to GET request
+        http::response<http::file_body> response { std::piecewise_construct,
+                                                   std::make_tuple(std::move(body)),
+                                                   std::make_tuple(http::status::ok, request.version())
+        };
+        response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        response.set(http::field::content_type, mimeType(path));
+        response.content_length(size);
+        response.keep_alive(request.keep_alive());
+        return response;
+    }
+}
+
+#endif //BOOSTPROJECTS_REQUESTHANDLER_H
@@ -0,0 +1,375 @@
+/**============================================================================
+Name        : ResponseCache.cpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Full-response cache for dynamic HTTP handlers
+============================================================================**/
+
+#include "ResponseCache.h"
+
+#include <format>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <optional>
+#include <exception>
+
+#include <boost/asio/post.hpp>
+#include <boost/beast/core/string.hpp>
+#include <boost/beast/version.hpp>
+
+namespace
+{
+    namespace beast = boost::beast;
+    using namespace ResponseCache;
+
+    struct CacheControl
+    {
+        std::optional<std::chrono::seconds> maxAge;
+        std::optional<std::chrono::seconds> sharedMaxAge;
+        std::optional<std::chrono::seconds> staleWhileRevalidate;
+        bool noStore { false };
+        bool noCache { false };
+        bool isPrivate { false };
+        bool isPublic { false };
+    };
+
+    std::string_view trim(std::string_view value) noexcept
+    {
+        while (!value.empty() && (' ' == value.front() || '\t' == value.front()))
+            value.remove_prefix(1);
+        while (!value.empty() && (' ' == value.back() || '\t' == value.back()))
+            value.remove_suffix(1);
+        return value;
+    }
+
+    CacheControl parseCacheControl(std::string_view value)
+    {
+        CacheControl control;
+        while (!value.empty())
+        {
+            const size_t comma = value.find(',');
+            const std::string_view directive = trim(value.substr(0, comma));
+            value = (std::string_view::npos == comma) ? std::string_view {} : value.substr(comma + 1);
+
+            const size_t equals = directive.find('=');
+            const std::string_view name = trim(directive.substr(0, equals));
+            const std::string_view argument = (std::string_view::npos == equals) ?
+                    std::string_view {} : trim(directive.substr(equals + 1));
+
+            const auto seconds = [argument]() -> std::optional<std::chrono::seconds> {
+                uint64_t number = 0;
+                const auto [ptr, ec] = std::from_chars(argument.data(), argument.data() + argument.size(), number);
+                if (std::errc {} != ec)
+                    return std::nullopt;
+                return std::chrono::seconds(number);
+            };
+
+            if (beast::iequals(name, "no-store"))
+                control.noStore = true;
+            else if (beast::iequals(name, "no-cache"))
+                control.noCache = true;
+            else if (beast::iequals(name, "private"))
+                control.isPrivate = true;
+            else if (beast::iequals(name, "public"))
+                control.isPublic = true;
+            else if (beast::iequals(name, "max-age"))
+                control.maxAge = seconds();
+            else if (beast::iequals(name, "s-maxage"))
+                control.sharedMaxAge = seconds();
+            else if (beast::iequals(name, "stale-while-revalidate"))
+                control.staleWhileRevalidate = seconds();
+        }
+        return control;
+    }
+
+    // Returns std::nullopt for "Vary: *": such a response can not be matched to later requests
+    std::optional<std::vector<std::string>> parseVary(std::string_view value)
+    {
+        std::vector<std::string> names;
+        for (const auto token: http::token_list { value })
+        {
+            if ("*" == token)
+                return std::nullopt;
+            std::string name { token };
+            std::ranges::transform(name, name.begin(), [](unsigned char c) { return std::tolower(c); });
+            names.push_back(std::move(name));
+        }
+        std::ranges::sort(names);
+        return names;
+    }
+
+    std::string secondaryKey(const std::vector<std::string>& vary,
+                             const Request& request)
+    {
+        std::string key;
+        for (const std::string& name: vary)
+            key.append(std::string_view { request[name] }).push_back('\n');
+        return key;
+    }
+
+    Response invoke(const Handler& handler,
+                    const Request& request)
+    {
+        try {
+            return handler(request);
+        }
+        catch (const std::exception& exc)
+        {
+            Response response { http::status::internal_server_error, request.version() };
+            response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+            response.set(http::field::content_type, "text/html");
+            response.body() = "An error occurred: '" + std::string(exc.what()) + "'";
+            return response;
+        }
+    }
+}
+
+namespace ResponseCache
+{
+    Cache::Cache(asio::any_io_executor worker,
+                 Clock::duration defaultTtl,
+                 Clock::duration defaultStale,
+                 size_t shardCount,
+                 size_t maxEntriesPerShard):
+        worker { std::move(worker) }, defaultTtl { defaultTtl }, defaultStale { defaultStale },
+        maxEntriesPerShard { maxEntriesPerShard }
+    {
+        shards.reserve(shardCount);
+        for (size_t i = 0; i < shardCount; ++i)
+            shards.push_back(std::make_unique<Shard>());
+    }
+
+    void Cache::get(std::shared_ptr<const Request> request,
+                    Handler handler,
+                    Callback done)
+    {
+        const CacheControl requestControl = parseCacheControl((*request)[http::field::cache_control]);
+        const bool cacheable = (http::verb::get == request->method() || http::verb::head == request->method());
+        if (!cacheable || requestControl.noStore)
+            return computeAlone(nullptr, {}, std::move(request), std::move(handler), std::move(done));
+
+        std::string primaryKey = std::format("{} {}", std::string_view { request->method_string() },
+                                             std::string_view { request->target() });
+        Shard& shard = shardFor(primaryKey);
+
+        // RFC 9111, section 3.5: the response to an authorized request may be meant for that user alone. It is
+        // neither served from the cache nor shared with a concurrent miss, store() keeps it if marked shareable.
+        if (request->count(http::field::authorization))
+            return computeAlone(&shard, std::move(primaryKey), std::move(request), std::move(handler), std::move(done));
+
+        const Clock::time_point now = Clock::now();
+
+        std::unique_lock lock { shard.mutex };
+        const auto variants = shard.variants.find(primaryKey);
+        std::string key = primaryKey + '\n';
+        if (shard.variants.end() != variants)
+            key.append(secondaryKey(variants->second.vary, *request));
+
+        if (shard.variants.end() != variants && !requestControl.noCache)
+        {
+            if (const auto entry = variants->second.entries.find(key); variants->second.entries.end() != entry)
+            {
+                CachedResponsePtr cached = entry->second.response;
+                shard.lru.splice(shard.lru.begin(), shard.lru, entry->second.position);
+                if (cached->fresh(now))
+                {
+                    ++hits;
+                    lock.unlock();
+                    return done(std::move(cached));
+                }
+                if (cached->usable(now))
+                {
+                    // Serve the stale copy while a single refresh runs in the background
+                    ++staleHits;
+                    const bool refreshing = shard.inFlight.contains(key);
+                    if (!refreshing)
+                        shard.inFlight.emplace(key, std::vector<Waiter> {});
+                    lock.unlock();
+
+                    if (!refreshing) {
+                        ++refreshes;
+                        compute(shard, std::move(primaryKey), std::move(key), std::move(request), std::move(handler));
+                    }
+                    return done(std::move(cached));
+                }
+            }
+        }
+
+        ++misses;
+        if (const auto waiting = shard.inFlight.find(key); shard.inFlight.end() != waiting)
+        {
+            ++coalesced;
+            waiting->second.push_back(Waiter { std::move(request), std::move(handler), std::move(done) });
+            return;
+        }
+        shard.inFlight.emplace(key, std::vector<Waiter> { Waiter { request, handler, std::move(done) } });
+        lock.unlock();
+
+        compute(shard, std::move(primaryKey), std::move(key), std::move(request), std::move(handler));
+    }
+
+    Stats Cache::stats() const noexcept
+    {
+        return Stats {
+            .hits = hits.load(std::memory_order::relaxed),
+            .staleHits = staleHits.load(std::memory_order::relaxed),
+            .misses = misses.load(std::memory_order::relaxed),
+            .coalesced = coalesced.load(std::memory_order::relaxed),
+            .refreshes = refreshes.load(std::memory_order::relaxed),
+        };
+    }
+
+    Cache::Shard& Cache::shardFor(std::string_view primaryKey) noexcept
+    {
+        return *shards[std::hash<std::string_view> {}(primaryKey) % shards.size()];
+    }
+
+    void Cache::compute(Shard& shard,
+                        std::string primaryKey,
+                        std::string key,
+                        std::shared_ptr<const Request> request,
+                        Handler handler)
+    {
+        asio::post(worker, [this, &shard, primaryKey = std::move(primaryKey), key = std::move(key),
+                            request = std::move(request), handler = std::move(handler)] {
+            Response response = invoke(handler, *request);
+            response.prepare_payload();
+            const CachedResponsePtr cached = serialize(response, Clock::now());
+
+            std::vector<Waiter> waiters;
+            {
+                std::lock_guard lock { shard.mutex };
+                store(shard, primaryKey, *request, response, cached);
+                if (auto node = shard.inFlight.extract(key))
+                    waiters = std::move(node.mapped());
+            }
+            complete(std::move(waiters), *request, response, cached);
+        });
+    }
+
+    void Cache::computeAlone(Shard* shard,
+                             std::string primaryKey,
+                             std::shared_ptr<const Request> request,
+                             Handler handler,
+                             Callback done)
+    {
+        asio::post(worker, [this, shard, primaryKey = std::move(primaryKey), request = std::move(request),
+                            handler = std::move(handler), done = std::move(done)] {
+            Response response = invoke(handler, *request);
+            response.prepare_payload();
+            const CachedResponsePtr cached = serialize(response, Clock::now());
+            if (nullptr != shard) {
+                std::lock_guard lock { shard->mutex };
+                store(*shard, primaryKey, *request, response, cached);
+            }
+            done(cached);
+        });
+    }
+
+    void Cache::complete(std::vector<Waiter> waiters,
+                         const Request& request,
+                         const Response& response,
+                         const CachedResponsePtr& cached)
+    {
+        // The waiters joined before the Vary of the response was known, and it may not be meant to be shared
+        // at all: a waiter gets it only when it would have been stored under the same variant for that waiter
+        const CacheControl control = parseCacheControl(response[http::field::cache_control]);
+        const std::optional<std::vector<std::string>> vary = parseVary(response[http::field::vary]);
+        const bool shareable = vary && !control.noStore && !control.noCache && !control.isPrivate;
+        const std::string variant = shareable ? secondaryKey(*vary, request) : std::string {};
+
+        for (Waiter& waiter: waiters)
+        {
+            if (&request == waiter.request.get() || (shareable && variant == secondaryKey(*vary, *waiter.request)))
+                waiter.done(cached);
+            else if (shareable)
+                // Another variant: looked up again, under the Vary this response has stored
+                get(std::move(waiter.request), std::move(waiter.handler), std::move(waiter.done));
+            else
+                computeAlone(nullptr, {}, std::move(waiter.request), std::move(waiter.handler), std::move(waiter.done));
+        }
+    }
+
+    void Cache::store(Shard& shard,
+                      const std::string& primaryKey,
+                      const Request& request,
+                      const Response& response,
+                      const CachedResponsePtr& cached)
+    {
+        const CacheControl control = parseCacheControl(response[http::field::cache_control]);
+        // no-cache: every reuse needs a revalidation (RFC 9111, section 5.2.2.4), which this cache doesn't do
+        if (http::status::ok != response.result() || control.noStore || control.noCache || control.isPrivate)
+            return;
+        // RFC 9111, section 3.5
+        if (request.count(http::field::authorization) && !control.isPublic && !control.sharedMaxAge)
+            return;
+
+        std::optional<std::vector<std::string>> vary = parseVary(response[http::field::vary]);
+        if (!vary)
+            return;
+
+        Variants& variants = shard.variants[primaryKey];
+        if (variants.vary != *vary)
+        {
+            for (const auto& [_, entry]: variants.entries)
+                shard.lru.erase(entry.position);
+            variants.vary = std::move(*vary);
+            variants.entries.clear();
+        }
+
+        std::string key = primaryKey + '\n' + secondaryKey(variants.vary, request);
+        if (const auto entry = variants.entries.find(key); variants.entries.end() != entry)
+        {
+            entry->second.response = cached;
+            shard.lru.splice(shard.lru.begin(), shard.lru, entry->second.position);
+            return;
+        }
+
+        shard.lru.emplace_front(primaryKey, key);
+        variants.entries.emplace(std::move(key), Entry { cached, shard.lru.begin() });
+        while (shard.lru.size() > std::max<size_t>(maxEntriesPerShard, 1))
+            evictOldest(shard);
+    }
+
+    void Cache::evictOldest(Shard& shard)
+    {
+        const auto& [primaryKey, key] = shard.lru.back();
+        if (const auto variants = shard.variants.find(primaryKey); shard.variants.end() != variants)
+        {
+            variants->second.entries.erase(key);
+            if (variants->second.entries.empty())
+                shard.variants.erase(variants);
+        }
+        shard.lru.pop_back();
+    }
+
+    CachedResponsePtr Cache::serialize(const Response& response,
+                                       Clock::time_point now) const
+    {
+        const CacheControl control = parseCacheControl(response[http::field::cache_control]);
+
+        auto cached = std::make_shared<CachedResponse>();
+        cached->head = std::format("HTTP/1.1 {} {}\r\n", response.result_int(), std::string_view { response.reason() });
+        for (const auto& field: response)
+        {
+            if (http::field::connection == field.name() || http::field::keep_alive == field.name())
+                continue;
+            cached->head.append(std::string_view { field.name_string() }).append(": ")
+                        .append(std::string_view { field.value() }).append("\r\n");
+        }
+        cached->body = response.body();
+        cached->created = now;
+        cached->expires = now + control.sharedMaxAge.value_or(control.maxAge.value_or(
+                std::chrono::duration_cast<std::chrono::seconds>(defaultTtl)));
+        // The default stale period only for a response without any freshness of its own: one with a max-age
+        // and no stale-while-revalidate is never served stale
+        const bool explicitFreshness = control.maxAge || control.sharedMaxAge;
+        cached->staleUntil = cached->expires + control.staleWhileRevalidate.value_or(
+                explicitFreshness ? std::chrono::seconds::zero()
+                                  : std::chrono::duration_cast<std::chrono::seconds>(defaultStale));
+        return cached;
+    }
+}
@@ -0,0 +1,180 @@
+/**============================================================================
+Name        : ResponseCache.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Full-response cache for dynamic HTTP handlers
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_RESPONSECACHE_H
+#define BOOSTPROJECTS_RESPONSECACHE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/beast/http.hpp>
+
+namespace ResponseCache
+{
+    namespace asio = boost::asio;
+    namespace http = boost::beast::http;
+
+    using Clock = std::chrono::steady_clock;
+    using Request = http::request<http::string_body>;
+    using Response = http::response<http::string_body>;
+    using Handler = std::function<Response(const Request&)>;
+
+    // Serialized response: immutable once published, shared by every session which serves it
+    struct CachedResponse
+    {
+        // Status line and header fields, without the empty line terminating the header.
+        // Connection-specific fields (Connection, Keep-Alive) are left to the session.
+        std::string head;
+        std::string body;
+
+        Clock::time_point created;
+        Clock::time_point expires;
+        Clock::time_point staleUntil;
+
+        [[nodiscard]]
+        bool fresh(Clock::time_point now) const noexcept {
+            return now < expires;
+        }
+
+        [[nodiscard]]
+        bool usable(Clock::time_point now) const noexcept {
+            return now < staleUntil;
+        }
+
+        [[nodiscard]]
+        std::chrono::seconds age(Clock::time_point now) const noexcept {
+            return std::chrono::duration_cast<std::chrono::seconds>(now - created);
+        }
+    };
+
+    using CachedResponsePtr = std::shared_ptr<const CachedResponse>;
+
+    // Invoked on the worker executor (or inline on a hit): the caller posts back to its own executor
+    using Callback = std::function<void(CachedResponsePtr)>;
+
+    struct Stats
+    {
+        uint64_t hits { 0 };
+        uint64_t staleHits { 0 };
+        uint64_t misses { 0 };
+        uint64_t coalesced { 0 };
+        uint64_t refreshes { 0 };
+    };
+
+    class Cache
+    {
+        // Primary key and full key of the stored entries, most recently used first
+        using Lru = std::list<std::pair<std::string, std::string>>;
+
+        struct Entry
+        {
+            CachedResponsePtr response;
+            Lru::iterator position;
+        };
+
+        struct Variants
+        {
+            // Request header names from the Vary field of the last stored response
+            std::vector<std::string> vary;
+            std::unordered_map<std::string, Entry> entries;
+        };
+
+        // A request waiting for the computation already running for its key
+        struct Waiter
+        {
+            std::shared_ptr<const Request> request;
+            Handler handler;
+            Callback done;
+        };
+
+        struct Shard
+        {
+            std::mutex mutex;
+            std::unordered_map<std::string, Variants> variants;
+            std::unordered_map<std::string, std::vector<Waiter>> inFlight;
+            Lru lru;
+        };
+
+        asio::any_io_executor worker;
+        Clock::duration defaultTtl;
+        Clock::duration defaultStale;
+        size_t maxEntriesPerShard;
+        std::vector<std::unique_ptr<Shard>> shards;
+
+        std::atomic<uint64_t> hits { 0 };
+        std::atomic<uint64_t> staleHits { 0 };
+        std::atomic<uint64_t> misses { 0 };
+        std::atomic<uint64_t> coalesced { 0 };
+        std::atomic<uint64_t> refreshes { 0 };
+
+    public:
+        // Handlers run on `worker`, so an expensive computation never blocks the I/O threads. The defaults
+        // apply to responses without max-age or s-maxage; no-cache responses are never stored.
+        Cache(asio::any_io_executor worker,
+              Clock::duration defaultTtl,
+              Clock::duration defaultStale,
+              size_t shardCount = 16,
+              size_t maxEntriesPerShard = 1024);
+
+        // Serves `request` from the cache or from `handler`. Concurrent misses for one key run `handler` once,
+        // a stale entry is served while a single background refresh runs. Requests with an Authorization
+        // field always run `handler`; their response is stored only when it is public or has s-maxage.
+        void get(std::shared_ptr<const Request> request,
+                 Handler handler,
+                 Callback done);
+
+        [[nodiscard]]
+        Stats stats() const noexcept;
+
+    private:
+        [[nodiscard]]
+        Shard& shardFor(std::string_view primaryKey) noexcept;
+
+        void compute(Shard& shard,
+                     std::string primaryKey,
+                     std::string key,
+                     std::shared_ptr<const Request> request,
+                     Handler handler);
+
+        // Runs `handler` for this request alone, storing the response in `shard` when one is given
+        void computeAlone(Shard* shard,
+                          std::string primaryKey,
+                          std::shared_ptr<const Request> request,
+                          Handler handler,
+                          Callback done);
+
+        // Hands the response computed for `request` to the requests which waited for it
+        void complete(std::vector<Waiter> waiters,
+                      const Request& request,
+                      const Response& response,
+                      const CachedResponsePtr& cached);
+
+        void store(Shard& shard,
+                   const std::string& primaryKey,
+                   const Request& request,
+                   const Response& response,
+                   const CachedResponsePtr& cached);
+
+        static void evictOldest(Shard& shard);
+
+        [[nodiscard]]
+        CachedResponsePtr serialize(const Response& response,
+                                    Clock::time_point now) const;
+    };
+}
+
+#endif //BOOSTPROJECTS_RESPONSECACHE_H
@@ -0,0 +1,543 @@
+/**============================================================================
+Name        : ReverseProxy.cpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : HTTPS reverse proxy with pooled keep-alive upstream connections
+============================================================================**/
+
+#include "ReverseProxy.h"
+
+#include <iostream>
+#include <string_view>
+#include <array>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <format>
+#include <chrono>
+#include <optional>
+
+#include <sys/socket.h>
+#include <cerrno>
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/as_tuple.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/beast/version.hpp>
+
+#include "server_certificate.hpp"
+
+namespace
+{
+    namespace asio  = boost::asio;
+    namespace beast = boost::beast;
+    namespace http  = beast::http;
+    namespace ssl   = asio::ssl;
+    namespace ip    = asio::ip;
+
+    using tcp = ip::tcp;
+    using Clock = std::chrono::steady_clock;
+
+    constexpr std::string_view host { "0.0.0.0" };
+    constexpr uint16_t port { 8444 };
+
+    // Local stand-in upstreams
+    constexpr std::array<uint16_t, 3> upstreamPorts { 9001, 9002, 9003 };
+
+    // Body bytes in flight per direction: bodies of any size are relayed through this much memory
+    constexpr size_t relayBufferSize { 16 * 1024 };
+    // Upper bound for buffered header bytes on either side
+    constexpr size_t headerBufferLimit { 64 * 1024 };
+
+    constexpr std::chrono::seconds ioTimeout { 30 };
+    constexpr std::chrono::seconds idleTimeout { 30 };
+    constexpr size_t maxIdlePerUpstream { 32 };
+    // Pause of the accept loop when the process is out of descriptors or memory
+    constexpr std::chrono::milliseconds acceptBackoff { 100 };
+
+    void fail(const beast::error_code& errorCode,
+              std::string_view what)
+    {
+        if (ssl::error::stream_truncated == errorCode || asio::error::eof == errorCode)
+            return;
+        std::cerr << what << ": " << errorCode.message() << "\n";
+    }
+}
+
+namespace ReverseProxy
+{
+    struct Upstream
+    {
+        tcp::endpoint endpoint;
+        // Requests currently forwarded to this upstream, from every I/O thread
+        std::atomic<uint32_t> outstanding { 0 };
+    };
+
+    // Least-outstanding-requests load balancing, shared by all I/O threads
+    class Balancer
+    {
+        std::vector<std::unique_ptr<Upstream>> upstreams;
+        std::atomic<size_t> rotation { 0 };
+
+    public:
+        void add(const tcp::endpoint& endpoint)
+        {
+            auto upstream = std::make_unique<Upstream>();
+            upstream->endpoint = endpoint;
+            upstreams.push_back(std::move(upstream));
+        }
+
+        [[nodiscard]]
+        size_t size() const noexcept {
+            return upstreams.size();
+        }
+
+        [[nodiscard]]
+        Upstream& at(size_t index) const noexcept {
+            return *upstreams[index];
+        }
+
+        // The scan starts at a rotating offset, so ties do not all land on the first upstream
+        [[nodiscard]]
+        size_t pick() noexcept
+        {
+            const size_t start = rotation.fetch_add(1, std::memory_order::relaxed);
+            size_t best = start % upstreams.size();
+            uint32_t bestLoad = upstreams[best]->outstanding.load(std::memory_order::relaxed);
+            for (size_t i = 1; i < upstreams.size() && bestLoad > 0; ++i)
+            {
+                const size_t index = (start + i) % upstreams.size();
+                const uint32_t load = upstreams[index]->outstanding.load(std::memory_order::relaxed);
+                if (load < bestLoad) {
+                    best = index;
+                    bestLoad = load;
+                }
+            }
+            return best;
+        }
+    };
+
+    struct Outstanding
+    {
+        Upstream& upstream;
+
+        explicit Outstanding(Upstream& target): upstream { target } {
+            upstream.outstanding.fetch_add(1, std::memory_order::relaxed);
+        }
+
+        ~Outstanding() {
+            upstream.outstanding.fetch_sub(1, std::memory_order::relaxed);
+        }
+    };
+
+    // An idle keep-alive connection may have been closed by the upstream in the meantime
+    bool isAlive(beast::tcp_stream& stream)
+    {
+        char byte;
+        const ssize_t result = ::recv(stream.socket().native_handle(), &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+        return result < 0 && (EAGAIN == errno || EWOULDBLOCK == errno);
+    }
+
+    // Idle keep-alive upstream connections of one I/O thread.
+    // Only that thread's io_context touches them, so there is no locking.
+    class ConnectionPool
+    {
+        struct IdleConnection
+        {
+            beast::tcp_stream stream;
+            Clock::time_point since;
+        };
+
+        const Balancer& balancer;
+        std::vector<std::vector<IdleConnection>> idle;
+
+    public:
+        explicit ConnectionPool(const Balancer& balancer): balancer { balancer }, idle(balancer.size()) {
+        }
+
+        asio::awaitable<beast::tcp_stream> acquire(size_t index)
+        {
+            std::vector<IdleConnection>& connections = idle[index];
+            while (!connections.empty())
+            {
+                IdleConnection connection = std::move(connections.back());
+                connections.pop_back();
+                if (Clock::now() - connection.since < idleTimeout && isAlive(connection.stream))
+                    co_return std::move(connection.stream);
+            }
+
+            beast::tcp_stream stream { co_await asio::this_coro::executor };
+            stream.expires_after(ioTimeout);
+            co_await stream.async_connect(balancer.at(index).endpoint);
+            stream.socket().set_option(tcp::no_delay(true));
+            co_return stream;
+        }
+
+        void release(size_t index,
+                     beast::tcp_stream&& stream)
+        {
+            std::vector<IdleConnection>& connections = idle[index];
+            if (connections.size() < maxIdlePerUpstream) {
+                stream.expires_never();
+                connections.push_back(IdleConnection { std::move(stream), Clock::now() });
+            }
+        }
+    };
+
+    struct Worker
+    {
+        asio::io_context ioContext { 1 };
+        asio::executor_work_guard<asio::io_context::executor_type> guard { ioContext.get_executor() };
+        ConnectionPool pool;
+
+        explicit Worker(const Balancer& balancer): pool { balancer } {
+        }
+    };
+
+    // Connection-level fields describe one hop and are never forwarded
+    template <bool isRequest>
+    void stripHopByHop(http::header<isRequest, http::fields>& header)
+    {
+        std::vector<std::string> named;
+        for (const auto token: http::token_list { header[http::field::connection] })
+            named.emplace_back(token);
+        for (const std::string& name: named)
+            header.erase(name);
+
+        header.erase(http::field::connection);
+        header.erase(http::field::keep_alive);
+        header.erase(http::field::te);
+        header.erase(http::field::trailer);
+        header.erase(http::field::upgrade);
+        header.erase(http::field::proxy_authorization);
+        header.erase("Proxy-Connection");
+    }
+
+    // Moves the body of a message from `input` to `output` through a fixed buffer.
+    // The header has already been read into `parser`: it is written first by the serializer.
+    template <bool isRequest, class OutputStream, class InputStream>
+    asio::awaitable<void> relay(OutputStream& output,
+                                InputStream& input,
+                                beast::flat_buffer& inputBuffer,
+                                http::parser<isRequest, http::buffer_body>& parser)
+    {
+        std::array<char, relayBufferSize> chunk {};
+        http::serializer<isRequest, http::buffer_body> serializer { parser.get() };
+
+        beast::get_lowest_layer(output).expires_after(ioTimeout);
+        co_await http::async_write_header(output, serializer);
+
+        do
+        {
+            if (!parser.is_done())
+            {
+                parser.get().body().data = chunk.data();
+                parser.get().body().size = chunk.size();
+
+                beast::get_lowest_layer(input).expires_after(ioTimeout);
+                const auto [readError, bytesRead] = co_await http::async_read(input, inputBuffer, parser, asio::as_tuple);
+                // need_buffer just means the chunk is full
+                if (readError && http::error::need_buffer != readError)
+                    throw boost::system::system_error(readError, "relay read");
+
+                parser.get().body().size = chunk.size() - parser.get().body().size;
+                parser.get().body().data = chunk.data();
+                parser.get().body().more = !parser.is_done();
+            }
+            else
+            {
+                parser.get().body().data = nullptr;
+                parser.get().body().size = 0;
+            }
+
+            beast::get_lowest_layer(output).expires_after(ioTimeout);
+            const auto [writeError, bytesWritten] = co_await http::async_write(output, serializer, asio::as_tuple);
+            if (writeError && http::error::need_buffer != writeError)
+                throw boost::system::system_error(writeError, "relay write");
+        }
+        while (!parser.is_done() && !serializer.is_done());
+    }
+
+    asio::awaitable<void> send_error(ssl::stream<beast::tcp_stream>& client,
+                                     http::status status,
+                                     unsigned version)
+    {
+        http::response<http::string_body> response { status, version };
+        response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        response.set(http::field::content_type, "text/html");
+        response.keep_alive(false);
+        response.body() = std::string(http::obsolete_reason(status));
+        response.prepare_payload();
+
+        beast::get_lowest_layer(client).expires_after(ioTimeout);
+        co_await http::async_write(client, response, asio::as_tuple);
+    }
+
+    asio::awaitable<void> session(tcp::socket socket,
+                                  ssl::context& ctx,
+                                  Balancer& balancer,
+                                  ConnectionPool& pool)
+    {
+        beast::error_code errorCode;
+        const std::string peer = socket.remote_endpoint(errorCode).address().to_string();
+        ssl::stream<beast::tcp_stream> client { std::move(socket), ctx };
+
+        try
+        {
+            beast::get_lowest_layer(client).expires_after(ioTimeout);
+            co_await client.async_handshake(ssl::stream_base::server);
+
+            beast::flat_buffer clientBuffer { headerBufferLimit };
+            while (true)
+            {
+                // Bodies are streamed, so no body limit: only the header size is bounded (by the buffer)
+                http::request_parser<http::buffer_body> request;
+                request.body_limit(boost::none);
+
+                beast::get_lowest_layer(client).expires_after(ioTimeout);
+                const auto [readError, _] = co_await http::async_read_header(client, clientBuffer, request, asio::as_tuple);
+                if (http::error::end_of_stream == readError)
+                    break;
+                if (readError)
+                    throw boost::system::system_error(readError, "read_header");
+
+                const unsigned version = request.get().version();
+                const bool keepAlive = request.get().keep_alive();
+                const bool headRequest = http::verb::head == request.get().method();
+                const bool expectContinue = beast::iequals(request.get()[http::field::expect], "100-continue");
+
+                stripHopByHop(request.get());
+                request.get().erase(http::field::expect);
+                request.get().set("X-Forwarded-For", peer);
+                request.get().set("X-Forwarded-Proto", "https");
+                request.get().keep_alive(true);
+
+                const size_t index = balancer.pick();
+                const Outstanding outstanding { balancer.at(index) };
+
+                std::optional<beast::tcp_stream> upstream;
+                try {
+                    upstream.emplace(co_await pool.acquire(index));
+                }
+                catch (const boost::system::system_error& exc) {
+                    fail(exc.code(), "connect");
+                }
+                if (!upstream)
+                {
+                    // The request body is still on the wire: the client connection is closed after the error
+                    co_await send_error(client, http::status::bad_gateway, version);
+                    break;
+                }
+                beast::tcp_stream& server = *upstream;
+
+                if (expectContinue)
+                {
+                    http::response<http::empty_body> proceed { http::status::continue_, version };
+                    beast::get_lowest_layer(client).expires_after(ioTimeout);
+                    co_await http::async_write(client, proceed);
+                }
+
+                beast::flat_buffer serverBuffer { headerBufferLimit };
+                http::response_parser<http::buffer_body> response;
+                response.body_limit(boost::none);
+                response.skip(headRequest);
+
+                // Until the response header is relayed the client has got nothing: a failure still gets an answer
+                std::optional<http::status> relayFailure;
+                try
+                {
+                    co_await relay(server, client, clientBuffer, request);
+
+                    beast::get_lowest_layer(server).expires_after(ioTimeout);
+                    co_await http::async_read_header(server, serverBuffer, response);
+                }
+                catch (const boost::system::system_error& exc) {
+                    fail(exc.code(), "upstream");
+                    relayFailure = beast::error::timeout == exc.code() ? http::status::gateway_timeout
+                                                                       : http::status::bad_gateway;
+                }
+                if (relayFailure)
+                {
+                    co_await send_error(client, *relayFailure, version);
+                    break;
+                }
+
+                const bool upstreamKeepAlive = response.get().keep_alive();
+                stripHopByHop(response.get());
+                response.get().keep_alive(keepAlive);
+
+                co_await relay(client, server, serverBuffer, response);
+
+                // The connection goes back to this thread's pool only if it is clean
+                if (upstreamKeepAlive && 0 == serverBuffer.size())
+                    pool.release(index, std::move(server));
+
+                if (!keepAlive)
+                    break;
+            }
+
+            beast::get_lowest_layer(client).expires_after(ioTimeout);
+            const auto [shutdownError] = co_await client.async_shutdown(asio::as_tuple);
+            if (shutdownError)
+                fail(shutdownError, "shutdown");
+        }
+        catch (const boost::system::system_error& exc) {
+            fail(exc.code(), exc.what());
+        }
+    }
+
+    // Accepts on one thread and hands each connection to the next I/O thread in turn
+    asio::awaitable<void> listen(ssl::context& ctx,
+                                 Balancer& balancer,
+                                 std::vector<std::unique_ptr<Worker>>& workers)
+    {
+        const asio::any_io_executor executor = co_await asio::this_coro::executor;
+        tcp::acceptor acceptor { executor, { ip::make_address(host), port } };
+        asio::steady_timer backoff { executor };
+        for (size_t next = 0; ; ++next)
+        {
+            Worker& worker = *workers[next % workers.size()];
+            auto [errorCode, socket] = co_await acceptor.async_accept(worker.ioContext, asio::as_tuple);
+            if (errorCode)
+            {
+                fail(errorCode, "accept");
+                if (asio::error::connection_aborted == errorCode)
+                    continue;
+                // Out of descriptors or memory: the pending connection stays queued, retrying at once would spin
+                if (asio::error::no_descriptors == errorCode || asio::error::no_buffer_space == errorCode ||
+                    asio::error::no_memory == errorCode ||
+                    boost::system::errc::too_many_files_open_in_system == errorCode)
+                {
+                    backoff.expires_after(acceptBackoff);
+                    co_await backoff.async_wait(asio::as_tuple);
+                    continue;
+                }
+                // The acceptor itself is broken
+                co_return;
+            }
+            asio::co_spawn(worker.ioContext, session(std::move(socket), ctx, balancer, worker.pool), asio::detached);
+        }
+    }
+}
+
+namespace ReverseProxy::StandIn
+{
+    // Loopback upstream: counts the request body through a small buffer and reports who answered
+    asio::awaitable<void> session(tcp::socket socket,
+                                  uint16_t upstreamPort)
+    {
+        beast::flat_buffer buffer;
+        std::array<char, 4096> chunk {};
+        try
+        {
+            while (true)
+            {
+                http::request_parser<http::buffer_body> request;
+                request.body_limit(boost::none);
+
+                const auto [readError, _] = co_await http::async_read_header(socket, buffer, request, asio::as_tuple);
+                if (readError)
+                    break;
+
+                uint64_t bodyBytes = 0;
+                while (!request.is_done())
+                {
+                    request.get().body().data = chunk.data();
+                    request.get().body().size = chunk.size();
+                    const auto [ec, bytes] = co_await http::async_read(socket, buffer, request, asio::as_tuple);
+                    if (ec && http::error::need_buffer != ec)
+                        co_return;
+                    bodyBytes += chunk.size() - request.get().body().size;
+                }
+
+                http::response<http::string_body> response { http::status::ok, request.get().version() };
+                response.set(http::field::server, std::format("upstream-{}", upstreamPort));
+                response.set(http::field::content_type, "text/plain");
+                response.keep_alive(request.get().keep_alive());
+                response.body() = std::format("upstream {}: {} {}, {} body bytes\n", upstreamPort,
+                                              std::string_view { request.get().method_string() },
+                                              std::string_view { request.get().target() }, bodyBytes);
+                response.prepare_payload();
+                co_await http::async_write(socket, response);
+
+                if (!response.keep_alive())
+                    break;
+            }
+        }
+        catch (const boost::system::system_error& exc) {
+            fail(exc.code(), "upstream");
+        }
+    }
+
+    asio::awaitable<void> run(uint16_t upstreamPort)
+    {
+        const asio::any_io_executor executor = co_await asio::this_coro::executor;
+        tcp::acceptor acceptor { executor, { ip::make_address_v4("127.0.0.1"), upstreamPort } };
+        while (true)
+        {
+            tcp::socket socket = co_await acceptor.async_accept();
+            asio::co_spawn(executor, session(std::move(socket), upstreamPort), asio::detached);
+        }
+    }
+}
+
+namespace ReverseProxy
+{
+    int runServer()
+    {
+        constexpr uint32_t threads { 4 };
+
+        try
+        {
+            ssl::context ctx { ssl::context::tlsv13 };
+            load_server_certificate(ctx);
+
+            Balancer balancer;
+            for (const uint16_t upstreamPort: upstreamPorts)
+                balancer.add(tcp::endpoint { ip::make_address_v4("127.0.0.1"), upstreamPort });
+
+            // One io_context per thread: each thread owns its sessions and its idle upstream connections
+            std::vector<std::unique_ptr<Worker>> workers;
+            for (uint32_t i = 0; i < threads; ++i)
+                workers.push_back(std::make_unique<Worker>(balancer));
+
+            for (const uint16_t upstreamPort: upstreamPorts)
+                asio::co_spawn(workers.front()->ioContext, StandIn::run(upstreamPort), asio::detached);
+
+            asio::co_spawn(workers.front()->ioContext, listen(ctx, balancer, workers), [](std::exception_ptr e) {
+                if (e) {
+                    std::rethrow_exception(e);
+                }
+            });
+
+            std::vector<std::thread> runners;
+            runners.reserve(threads - 1);
+            for (uint32_t i = 1; i < threads; ++i)
+                runners.emplace_back([&worker = *workers[i]] { worker.ioContext.run(); });
+            workers.front()->ioContext.run();
+
+            return EXIT_SUCCESS;
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+}
+
+// curl -k https://localhost:8444/any/path
+// curl -k -T big.bin https://localhost:8444/upload
+void ReverseProxy::TestAll()
+{
+    runServer();
+}
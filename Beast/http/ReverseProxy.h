@@ -0,0 +1,18 @@
+/**============================================================================
+Name        : ReverseProxy.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : ReverseProxy.h
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_REVERSEPROXY_H
+#define BOOSTPROJECTS_REVERSEPROXY_H
+
+namespace ReverseProxy
+{
+    void TestAll();
+};
+
+#endif //BOOSTPROJECTS_REVERSEPROXY_H
@@ -0,0 +1,263 @@
+/**============================================================================
+Name        : Singleflight.cpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Coalescing of identical in-flight client GETs, with a short micro-cache
+============================================================================**/
+
+#include "Singleflight.h"
+
+#include <iostream>
+#include <format>
+#include <print>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cctype>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/as_tuple.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include "trust_store.hpp"
+
+namespace
+{
+    using namespace Singleflight;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    namespace ssl = asio::ssl;
+
+    bool coalescable(http::verb method) noexcept
+    {
+        return http::verb::get == method || http::verb::head == method;
+    }
+
+    // Headers that don't change the answer. Tracing ids differ on every request: keyed on, nothing would coalesce.
+    constexpr std::array<std::string_view, 7> ignoredHeaders {
+        "user-agent", "connection", "keep-alive", "te", "traceparent", "tracestate", "x-request-id"
+    };
+
+    // Sent with credentials: the answer may belong to one user, it is never shared
+    bool personal(const Request& request)
+    {
+        return request.count(http::field::authorization) || request.count(http::field::proxy_authorization)
+               || request.count(http::field::cookie);
+    }
+
+    // Requests differing in any other header may get different answers: they never share a flight.
+    // The headers are sorted, their order on the wire doesn't matter.
+    std::string keyOf(const Origin& origin,
+                      const Request& request)
+    {
+        std::vector<std::string> headers;
+        for (const auto& field: request)
+        {
+            std::string name { field.name_string() };
+            std::ranges::transform(name, name.begin(), [](unsigned char c) { return std::tolower(c); });
+            if (std::ranges::find(ignoredHeaders, name) == ignoredHeaders.end())
+                headers.push_back(std::format("{}: {}", name, field.value()));
+        }
+        std::ranges::sort(headers);
+
+        std::string key = std::format("{} {}{}", request.method_string(), origin.key(), request.target());
+        for (const std::string& header: headers) {
+            key += '\n';
+            key += header;
+        }
+        return key;
+    }
+
+    // Joined while in flight but not kept afterwards: the server asked for every request to reach it
+    bool reusable(const Response& response)
+    {
+        std::string_view value = response[http::field::cache_control];
+        while (!value.empty())
+        {
+            const size_t comma = value.find(',');
+            std::string_view name = value.substr(0, std::min(comma, value.find('=')));
+            value = (std::string_view::npos == comma) ? std::string_view {} : value.substr(comma + 1);
+
+            while (!name.empty() && (' ' == name.front() || '\t' == name.front()))
+                name.remove_prefix(1);
+            while (!name.empty() && (' ' == name.back() || '\t' == name.back()))
+                name.remove_suffix(1);
+            if (beast::iequals(name, "no-store") || beast::iequals(name, "no-cache") || beast::iequals(name, "private"))
+                return false;
+        }
+        return true;
+    }
+}
+
+namespace Singleflight
+{
+    Group::Group(asio::any_io_executor executor,
+                 ConnectionPool::Pool& pool,
+                 Options options)
+        : executor { std::move(executor) }, pool { pool }, options { options } {
+    }
+
+    asio::awaitable<ResponsePtr> Group::send(const Origin& origin,
+                                             Request request)
+    {
+        if (!coalescable(request.method()) || personal(request)) {
+            ++passThrough;
+            co_return std::make_shared<const Response>(co_await ConnectionPool::send(pool, origin, std::move(request)));
+        }
+
+        std::string key = keyOf(origin, request);
+        std::shared_ptr<Flight> flight;
+        bool leader = false;
+        const auto signal = std::make_shared<Signal>(executor, 1);
+        {
+            std::lock_guard lock { mutex };
+            const Clock::time_point now = Clock::now();
+            auto iter = flights.find(key);
+            if (flights.end() != iter && iter->second->done && now >= iter->second->expires) {
+                flights.erase(iter);
+                iter = flights.end();
+            }
+
+            if (flights.end() != iter)
+            {
+                flight = iter->second;
+                if (flight->done) {
+                    ++microHits;
+                    co_return flight->response;
+                }
+                ++joined;
+            }
+            else
+            {
+                if (flights.size() >= options.maxEntries)
+                    evictExpired(now);
+                flight = std::make_shared<Flight>();
+                flights.emplace(key, flight);
+                leader = true;
+                ++sent;
+            }
+            flight->waiters.push_back(signal);
+        }
+
+        // Outside the lock: the flight may run inline up to its first suspension
+        if (leader)
+            asio::co_spawn(executor, fly(std::move(key), flight, origin, std::move(request)), asio::detached);
+
+        co_await signal->async_receive(asio::as_tuple(asio::use_awaitable));
+
+        std::lock_guard lock { mutex };
+        if (flight->error)
+            std::rethrow_exception(flight->error);
+        co_return flight->response;
+    }
+
+    asio::awaitable<void> Group::fly(std::string key,
+                                     std::shared_ptr<Flight> flight,
+                                     Origin origin,
+                                     Request request)
+    {
+        ResponsePtr response;
+        std::exception_ptr error;
+        try {
+            response = std::make_shared<const Response>(co_await ConnectionPool::send(pool, origin, std::move(request)));
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+
+        std::lock_guard lock { mutex };
+        flight->response = std::move(response);
+        flight->error = error;
+        flight->done = true;
+        flight->expires = Clock::now() + options.microCache;
+
+        // Errors and server failures are not kept: the next request tries again
+        const bool keep = !error && Clock::duration::zero() < options.microCache
+                          && flight->response->result_int() < 500 && reusable(*flight->response);
+        if (!keep) {
+            if (const auto iter = flights.find(key); flights.end() != iter && iter->second == flight)
+                flights.erase(iter);
+        }
+
+        for (const std::shared_ptr<Signal>& waiter: flight->waiters)
+            waiter->try_send(boost::system::error_code {});
+        flight->waiters.clear();
+    }
+
+    void Group::evictExpired(Clock::time_point now)
+    {
+        std::erase_if(flights, [now](const auto& item) {
+            return item.second->done && now >= item.second->expires;
+        });
+    }
+
+    Stats Group::stats() const noexcept
+    {
+        return Stats {
+            .flights = sent.load(),
+            .joined = joined.load(),
+            .microHits = microHits.load(),
+            .passThrough = passThrough.load()
+        };
+    }
+}
+
+// HTTPS_Server on 8443: a herd of identical GETs becomes one request
+void Singleflight::TestAll()
+{
+    using namespace std::chrono_literals;
+    constexpr size_t herd { 200 };
+
+    asio::io_context ioCtx;
+    ssl::context ctx { ssl::context::tlsv13_client };
+    load_shared_root_certificates(ctx);
+    ConnectionPool::Pool pool { ioCtx.get_executor(), ctx };
+    Group group { ioCtx.get_executor(), pool, Options { .microCache = 100ms } };
+    const Origin origin { "127.0.0.1", 8443 };
+
+    const auto report = [&](std::string_view step) {
+        const Stats stats = group.stats();
+        std::println("{:<28} flights {}, joined {}, micro-cache hits {}", step,
+                     stats.flights, stats.joined, stats.microHits);
+    };
+
+    asio::co_spawn(ioCtx, [&]() -> asio::awaitable<void> {
+        const asio::any_io_executor executor = co_await asio::this_coro::executor;
+        asio::steady_timer timer { executor };
+        const auto stampede = [&]() -> asio::awaitable<void> {
+            size_t left = herd;
+            auto done = std::make_shared<asio::experimental::concurrent_channel<void(boost::system::error_code)>>(
+                    executor, 1);
+            for (size_t i = 0; i < herd; ++i) {
+                asio::co_spawn(executor, group.send(origin, Request { http::verb::get, "/", 11 }),
+                               [&, done](const std::exception_ptr&, const ResponsePtr&) {
+                    if (0 == --left)
+                        done->try_send(boost::system::error_code {});
+                });
+            }
+            co_await done->async_receive(asio::as_tuple(asio::use_awaitable));
+        };
+
+        co_await stampede();
+        report("concurrent herd");
+
+        // Within the micro-cache window: answered without a request
+        co_await stampede();
+        report("herd within 100 ms");
+
+        timer.expires_after(150ms);
+        co_await timer.async_wait();
+        co_await stampede();
+        report("herd after expiry");
+    }, [&](const std::exception_ptr& exc) {
+        pool.close();
+        if (exc)
+            std::rethrow_exception(exc);
+    });
+    ioCtx.run();
+}
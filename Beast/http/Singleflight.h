@@ -0,0 +1,111 @@
+/**============================================================================
+Name        : Singleflight.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Coalescing of identical in-flight client GETs, with a short micro-cache
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_SINGLEFLIGHT_H
+#define BOOSTPROJECTS_SINGLEFLIGHT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <unordered_map>
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
+
+#include "ConnectionPool.h"
+
+namespace Singleflight
+{
+    namespace asio = boost::asio;
+
+    using Clock = std::chrono::steady_clock;
+    using ConnectionPool::Origin;
+    using ConnectionPool::Request;
+    using ConnectionPool::Response;
+
+    // Shared by every caller of the same flight: never modified
+    using ResponsePtr = std::shared_ptr<const Response>;
+
+    struct Options
+    {
+        // A completed response keeps answering identical requests that long, unless its Cache-Control has
+        // no-store, no-cache or private. Zero: coalescing only.
+        Clock::duration microCache { std::chrono::milliseconds(100) };
+        size_t maxEntries { 1024 };
+    };
+
+    struct Stats
+    {
+        // Requests actually sent
+        uint64_t flights { 0 };
+        // Requests that joined a flight in progress
+        uint64_t joined { 0 };
+        uint64_t microHits { 0 };
+        // Other methods and requests with credentials, sent as they are
+        uint64_t passThrough { 0 };
+    };
+
+    class Group
+    {
+        using Signal = asio::experimental::concurrent_channel<void(boost::system::error_code)>;
+
+        struct Flight
+        {
+            ResponsePtr response;
+            std::exception_ptr error;
+            bool done { false };
+            Clock::time_point expires;
+            std::vector<std::shared_ptr<Signal>> waiters;
+        };
+
+        asio::any_io_executor executor;
+        ConnectionPool::Pool& pool;
+        const Options options;
+
+        std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<Flight>> flights;
+
+        std::atomic<uint64_t> sent { 0 };
+        std::atomic<uint64_t> joined { 0 };
+        std::atomic<uint64_t> microHits { 0 };
+        std::atomic<uint64_t> passThrough { 0 };
+
+    public:
+        // Flights run on `executor`, detached from their callers: cancelling one caller doesn't fail the others.
+        // The group must outlive its flights.
+        Group(asio::any_io_executor executor,
+              ConnectionPool::Pool& pool,
+              Options options = {});
+
+        // GET and HEAD requests with the same origin, target and headers (User-Agent and tracing ids aside)
+        // share one response. Other methods and requests with Authorization or Cookie go straight to the pool.
+        asio::awaitable<ResponsePtr> send(const Origin& origin,
+                                          Request request);
+
+        [[nodiscard]]
+        Stats stats() const noexcept;
+
+    private:
+        asio::awaitable<void> fly(std::string key,
+                                  std::shared_ptr<Flight> flight,
+                                  Origin origin,
+                                  Request request);
+
+        void evictExpired(Clock::time_point now);
+    };
+
+    void TestAll();
+}
+
+#endif //BOOSTPROJECTS_SINGLEFLIGHT_H
@@ -0,0 +1,221 @@
+/**============================================================================
+Name        : TlsSessionStore.cpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Client-side TLS session resumption, sessions kept per host and port
+============================================================================**/
+
+#include "TlsSessionStore.h"
+
+#include <iostream>
+#include <format>
+#include <print>
+#include <string>
+#include <chrono>
+#include <ctime>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/as_tuple.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/beast/version.hpp>
+
+#include "trust_store.hpp"
+
+namespace
+{
+    using namespace TlsSessionStore;
+
+    namespace asio = boost::asio;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    using tcp = asio::ip::tcp;
+
+    // host:port of the connection, owned by the SSL object and deleted with it
+    void freeKey(void*, void* ptr, CRYPTO_EX_DATA*, int, long, void*)
+    {
+        delete static_cast<std::string*>(ptr);
+    }
+
+    int keyIndex()
+    {
+        static const int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, freeKey);
+        return index;
+    }
+
+    int storeIndex()
+    {
+        static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+        return index;
+    }
+
+    bool resumable(const SSL_SESSION* session) noexcept
+    {
+        return 1 == SSL_SESSION_is_resumable(session) &&
+               SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session) > std::time(nullptr);
+    }
+
+    // Connects, sends one GET and reads the response: with TLS 1.3 the ticket arrives with the first read
+    asio::awaitable<std::chrono::microseconds> fetchOnce(ssl::context& ctx,
+                                                         Store& store,
+                                                         const std::string& host,
+                                                         uint16_t port)
+    {
+        const asio::any_io_executor executor = co_await asio::this_coro::executor;
+        tcp::resolver resolver { executor };
+        ssl::stream<beast::tcp_stream> stream { executor, ctx };
+
+        if (!SSL_set_tlsext_host_name(stream.native_handle(), host.c_str()))
+            throw boost::system::system_error(static_cast<int>(::ERR_get_error()), asio::error::get_ssl_category());
+
+        const auto results = co_await resolver.async_resolve(host, std::to_string(port));
+        beast::get_lowest_layer(stream).expires_after(std::chrono::seconds(10));
+        co_await beast::get_lowest_layer(stream).async_connect(results);
+
+        store.attach(stream.native_handle(), host, port);
+        const auto start = std::chrono::steady_clock::now();
+        co_await stream.async_handshake(ssl::stream_base::client);
+        const auto handshake = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+        store.record(stream.native_handle());
+
+        http::request<http::empty_body> request { http::verb::get, "/", 11 };
+        request.set(http::field::host, host);
+        request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+        co_await http::async_write(stream, request);
+
+        beast::flat_buffer buffer;
+        http::response<http::string_body> response;
+        co_await http::async_read(stream, buffer, response);
+
+        const auto [ec] = co_await stream.async_shutdown(asio::as_tuple);
+        if (ec && ec != asio::ssl::error::stream_truncated)
+            throw boost::system::system_error(ec, "shutdown");
+        co_return handshake;
+    }
+}
+
+namespace TlsSessionStore
+{
+    Store::Store(ssl::context& ctx,
+                 size_t maxEntries): context { ctx.native_handle() }, maxEntries { maxEntries }
+    {
+        // Client cache without OpenSSL's internal store: it would keep sessions by session id, not by server
+        SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_set_ex_data(context, storeIndex(), this);
+        SSL_CTX_sess_set_new_cb(context, &Store::on_new_session);
+    }
+
+    // A ticket arriving on the context after this must not reach the destroyed store
+    Store::~Store()
+    {
+        SSL_CTX_sess_set_new_cb(context, nullptr);
+        SSL_CTX_set_ex_data(context, storeIndex(), nullptr);
+    }
+
+    int Store::on_new_session(SSL* ssl,
+                              SSL_SESSION* session)
+    {
+        auto* const store = static_cast<Store*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), storeIndex()));
+        const auto* const key = static_cast<const std::string*>(SSL_get_ex_data(ssl, keyIndex()));
+        if (nullptr == store || nullptr == key || !resumable(session))
+            return 0;
+
+        {
+            std::lock_guard lock { store->mutex };
+            auto iter = store->sessions.find(*key);
+            if (store->sessions.end() != iter) {
+                iter->second.reset(session);
+            } else {
+                if (store->sessions.size() >= store->maxEntries)
+                    store->sessions.erase(store->sessions.begin());
+                store->sessions.emplace(*key, SessionPtr { session, SSL_SESSION_free });
+            }
+        }
+        ++store->stored;
+        // The store keeps the reference OpenSSL passed in
+        return 1;
+    }
+
+    void Store::attach(SSL* ssl,
+                       const std::string& host,
+                       uint16_t port)
+    {
+        auto* const key = new std::string(std::format("{}:{}", host, port));
+        delete static_cast<std::string*>(SSL_get_ex_data(ssl, keyIndex()));
+        SSL_set_ex_data(ssl, keyIndex(), key);
+
+        std::lock_guard lock { mutex };
+        if (const auto iter = sessions.find(*key); sessions.end() != iter)
+        {
+            if (!resumable(iter->second.get())) {
+                sessions.erase(iter);
+            } else if (1 == SSL_set_session(ssl, iter->second.get())) {
+                ++offered;
+            }
+        }
+    }
+
+    void Store::record(SSL* ssl) noexcept
+    {
+        ++handshakes;
+        if (1 == SSL_session_reused(ssl))
+            ++resumed;
+    }
+
+    void Store::forget(const std::string& host,
+                       uint16_t port)
+    {
+        std::lock_guard lock { mutex };
+        sessions.erase(std::format("{}:{}", host, port));
+    }
+
+    Stats Store::stats() const noexcept
+    {
+        return Stats {
+            .handshakes = handshakes.load(),
+            .resumed = resumed.load(),
+            .offered = offered.load(),
+            .stored = stored.load()
+        };
+    }
+}
+
+void TlsSessionStore::TestAll()
+{
+    const std::string host { "127.0.0.1" };
+    constexpr uint16_t port { 8443 };
+    constexpr int connections { 20 };
+
+    asio::io_context ioCtx;
+    ssl::context ctx { ssl::context::tlsv13_client };
+    load_shared_root_certificates(ctx);
+    Store store { ctx };
+
+    asio::co_spawn(ioCtx, [&]() -> asio::awaitable<void> {
+        std::chrono::microseconds full {}, resumed {};
+        for (int i = 0; i < connections; ++i)
+        {
+            const uint64_t before = store.stats().resumed;
+            const std::chrono::microseconds handshake = co_await fetchOnce(ctx, store, host, port);
+            (store.stats().resumed > before ? resumed : full) += handshake;
+        }
+
+        const Stats stats = store.stats();
+        const uint64_t fullCount = stats.handshakes - stats.resumed;
+        std::println("handshakes: {}, resumed: {} ({:.1f}%), sessions stored: {}, offered: {}",
+                     stats.handshakes, stats.resumed, stats.resumptionRate() * 100, stats.stored, stats.offered);
+        std::println("mean handshake: full {} us, resumed {} us",
+                     0 == fullCount ? 0 : full.count() / int64_t(fullCount),
+                     0 == stats.resumed ? 0 : resumed.count() / int64_t(stats.resumed));
+    }, [](const std::exception_ptr& exc) {
+        if (exc)
+            std::rethrow_exception(exc);
+    });
+    ioCtx.run();
+}
@@ -0,0 +1,87 @@
+/**============================================================================
+Name        : TlsSessionStore.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Client-side TLS session resumption, sessions kept per host and port
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_TLSSESSIONSTORE_H
+#define BOOSTPROJECTS_TLSSESSIONSTORE_H
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+#include <boost/asio/ssl.hpp>
+
+namespace TlsSessionStore
+{
+    namespace ssl = boost::asio::ssl;
+
+    struct Stats
+    {
+        uint64_t handshakes { 0 };
+        uint64_t resumed { 0 };
+        // Sessions offered to the server with SSL_set_session
+        uint64_t offered { 0 };
+        uint64_t stored { 0 };
+
+        [[nodiscard]]
+        double resumptionRate() const noexcept {
+            return 0 == handshakes ? 0.0 : double(resumed) / double(handshakes);
+        }
+    };
+
+    // Sessions come from the new-session callback rather than from SSL_get1_session() after the handshake:
+    // TLS 1.3 servers send their tickets after the handshake is complete.
+    class Store
+    {
+        using SessionPtr = std::unique_ptr<SSL_SESSION, decltype(&SSL_SESSION_free)>;
+
+        // Outlives the store in the usual declaration order: the callback is removed from it on destruction
+        SSL_CTX* const context;
+        std::mutex mutex;
+        std::unordered_map<std::string, SessionPtr> sessions;
+        const size_t maxEntries;
+
+        std::atomic<uint64_t> handshakes { 0 };
+        std::atomic<uint64_t> resumed { 0 };
+        std::atomic<uint64_t> offered { 0 };
+        std::atomic<uint64_t> stored { 0 };
+
+        static int on_new_session(SSL* ssl,
+                                  SSL_SESSION* session);
+
+    public:
+        // Enables the client session cache of `ctx` and routes its new sessions here. One store per context.
+        explicit Store(ssl::context& ctx,
+                       size_t maxEntries = 1024);
+
+        ~Store();
+
+        Store(const Store&) = delete;
+        Store& operator=(const Store&) = delete;
+
+        // Before the handshake: tags the connection with host:port and offers the session saved for it
+        void attach(SSL* ssl,
+                    const std::string& host,
+                    uint16_t port);
+
+        // After a successful handshake: counts full and resumed handshakes
+        void record(SSL* ssl) noexcept;
+
+        void forget(const std::string& host,
+                    uint16_t port);
+
+        [[nodiscard]]
+        Stats stats() const noexcept;
+    };
+
+    void TestAll();
+}
+
+#endif //BOOSTPROJECTS_TLSSESSIONSTORE_H
@@ -11,8 +11,19 @@ Description : Boost Beast modules tests
 #include <vector>
 
 #include "Client.h"
+#include "ConnectionPool.h"
+#include "DnsCache.h"
+#include "TlsSessionStore.h"
+#include "FanOut.h"
+#include "Hedging.h"
+#include "JsonStream.h"
+#include "Singleflight.h"
+#include "HappyEyeballs.h"
+#include "LoadBalancer.h"
 #include "HTTPServer.h"
 #include "HTTPS_Server.h"
+#include "ReverseProxy.h"
+#include "Http2Server.h"
 #include "WebSocketServers.h"
 #include "WebSocketClients.h"
 
@@ -23,9 +34,20 @@ int main([[maybe_unused]] int argc,
     const std::vector<std::string_view> args(argv + 1, argv + argc);
 
     // Client::TestAll();
+    // ConnectionPool::TestAll();
+    // DnsCache::TestAll();
+    // TlsSessionStore::TestAll();
+    // FanOut::TestAll();
+    // Hedging::TestAll();
+    // JsonStream::TestAll();
+    // Singleflight::TestAll();
+    // HappyEyeballs::TestAll();
+    // LoadBalancer::TestAll();
 
     // HTTPServer::TestAll();
     // HTTPS_Server::TestAll();
+    // ReverseProxy::TestAll();
+    // Http2Server::TestAll();
 
     // WebSocketServers::TestAll();
     WebSocketClients::TestAll();
@@ -0,0 +1,336 @@
+/**============================================================================
+Name        : BinaryCodec.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : Compact binary encoding of structs described with BOOST_DESCRIBE_STRUCT
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_BINARYCODEC_H
+#define BOOSTPROJECTS_BINARYCODEC_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <concepts>
+#include <type_traits>
+#include <bit>
+#include <cstring>
+#include <cstdint>
+
+#include <boost/describe.hpp>
+#include <boost/mp11.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+
+/**
+ * Wire format, fields in declaration order, no names and no tags:
+ *   - bool, integers, floating point and enums: fixed width, little-endian
+ *   - Varint<T>: LEB128, zigzag for signed types
+ *   - std::string, std::string_view: varint length, then the bytes
+ *   - std::vector<T>: varint count, then the elements
+ *   - std::optional<T>: one byte flag, then the value when present
+ *   - described structs: their members
+ * Decoding reads straight from the received buffer: std::string_view fields point into it.
+ */
+namespace BinaryCodec
+{
+    namespace asio = boost::asio;
+    namespace beast = boost::beast;
+    namespace describe = boost::describe;
+
+    // An integer field encoded in 1 to 10 bytes depending on its value
+    template <std::integral T>
+    struct Varint
+    {
+        T value {};
+
+        Varint& operator=(T newValue) noexcept {
+            value = newValue;
+            return *this;
+        }
+
+        operator T() const noexcept {
+            return value;
+        }
+    };
+
+    template <class T>
+    concept Described = describe::has_describe_members<T>::value;
+
+    namespace detail
+    {
+        template <class T>
+        struct IsVarint : std::false_type {};
+        template <class T>
+        struct IsVarint<Varint<T>> : std::true_type {};
+
+        template <class T>
+        struct IsVector : std::false_type {};
+        template <class T, class A>
+        struct IsVector<std::vector<T, A>> : std::true_type {};
+
+        template <class T>
+        struct IsOptional : std::false_type {};
+        template <class T>
+        struct IsOptional<std::optional<T>> : std::true_type {};
+
+        template <class T>
+        concept Fixed = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+        template <class T>
+        using Members = describe::describe_members<T, describe::mod_public | describe::mod_inherited>;
+
+        template <std::unsigned_integral U>
+        constexpr U littleEndian(U value) noexcept
+        {
+            if constexpr (std::endian::big == std::endian::native)
+                return std::byteswap(value);
+            else
+                return value;
+        }
+
+        // Fixed-width types as unsigned integers of the same size
+        template <Fixed T>
+        using Bits = std::conditional_t<1 == sizeof(T), uint8_t,
+                     std::conditional_t<2 == sizeof(T), uint16_t,
+                     std::conditional_t<4 == sizeof(T), uint32_t, uint64_t>>>;
+    }
+
+    class Writer
+    {
+        std::string& out;
+
+    public:
+        explicit Writer(std::string& out): out { out } {
+        }
+
+        template <detail::Fixed T>
+        void fixed(T value)
+        {
+            using Bits = detail::Bits<T>;
+            const Bits bits = detail::littleEndian(std::bit_cast<Bits>(value));
+            char bytes[sizeof(Bits)];
+            std::memcpy(bytes, &bits, sizeof(Bits));
+            out.append(bytes, sizeof(Bits));
+        }
+
+        void varint(uint64_t value)
+        {
+            while (value >= 0x80) {
+                out.push_back(static_cast<char>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        void bytes(std::string_view value)
+        {
+            varint(value.size());
+            out.append(value);
+        }
+    };
+
+    // Every read is bounds checked: a truncated or malformed message fails instead of reading past the buffer
+    class Reader
+    {
+        const char* position;
+        const char* end;
+
+    public:
+        explicit Reader(asio::const_buffer buffer) noexcept
+            : position { static_cast<const char*>(buffer.data()) }, end { position + buffer.size() } {
+        }
+
+        [[nodiscard]]
+        size_t remaining() const noexcept {
+            return static_cast<size_t>(end - position);
+        }
+
+        template <detail::Fixed T>
+        bool fixed(T& value) noexcept
+        {
+            using Bits = detail::Bits<T>;
+            if (remaining() < sizeof(Bits))
+                return false;
+            Bits bits;
+            std::memcpy(&bits, position, sizeof(Bits));
+            position += sizeof(Bits);
+            // Any byte other than 0 or 1 would not be a valid bool representation
+            if constexpr (std::is_same_v<T, bool>)
+                value = 0 != bits;
+            else
+                value = std::bit_cast<T>(detail::littleEndian(bits));
+            return true;
+        }
+
+        bool varint(uint64_t& value) noexcept
+        {
+            value = 0;
+            for (uint32_t shift = 0; shift < 64 && position != end; shift += 7)
+            {
+                const auto byte = static_cast<uint8_t>(*position++);
+                value |= uint64_t { byte & 0x7fU } << shift;
+                if (0 == (byte & 0x80))
+                    return true;
+            }
+            return false;
+        }
+
+        bool bytes(std::string_view& value) noexcept
+        {
+            uint64_t size = 0;
+            if (!varint(size) || size > remaining())
+                return false;
+            value = std::string_view { position, static_cast<size_t>(size) };
+            position += size;
+            return true;
+        }
+    };
+
+    template <class T>
+    void encodeValue(Writer& writer, const T& value);
+
+    template <class T>
+    bool decodeValue(Reader& reader, T& value);
+
+    template <class T>
+    void encodeValue(Writer& writer, const T& value)
+    {
+        if constexpr (detail::Fixed<T>) {
+            writer.fixed(value);
+        } else if constexpr (detail::IsVarint<T>::value) {
+            using Value = decltype(value.value);
+            if constexpr (std::is_signed_v<Value>) {
+                const auto number = static_cast<int64_t>(value.value);
+                writer.varint((static_cast<uint64_t>(number) << 1) ^ static_cast<uint64_t>(number >> 63));
+            } else {
+                writer.varint(value.value);
+            }
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            writer.bytes(value);
+        } else if constexpr (detail::IsVector<T>::value) {
+            writer.varint(value.size());
+            for (const auto& element: value)
+                encodeValue(writer, element);
+        } else if constexpr (detail::IsOptional<T>::value) {
+            writer.fixed(value.has_value());
+            if (value)
+                encodeValue(writer, *value);
+        } else {
+            static_assert(Described<T>, "BinaryCodec: the type is neither supported nor described");
+            boost::mp11::mp_for_each<detail::Members<T>>([&](auto member) {
+                encodeValue(writer, value.*member.pointer);
+            });
+        }
+    }
+
+    template <class T>
+    bool decodeValue(Reader& reader, T& value)
+    {
+        if constexpr (detail::Fixed<T>) {
+            return reader.fixed(value);
+        } else if constexpr (detail::IsVarint<T>::value) {
+            using Value = decltype(value.value);
+            uint64_t number = 0;
+            if (!reader.varint(number))
+                return false;
+            if constexpr (std::is_signed_v<Value>)
+                value.value = static_cast<Value>(static_cast<int64_t>(number >> 1) ^ -static_cast<int64_t>(number & 1));
+            else
+                value.value = static_cast<Value>(number);
+            return true;
+        } else if constexpr (std::is_same_v<T, std::string_view>) {
+            return reader.bytes(value);
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            std::string_view bytes;
+            if (!reader.bytes(bytes))
+                return false;
+            value.assign(bytes);
+            return true;
+        } else if constexpr (detail::IsVector<T>::value) {
+            uint64_t count = 0;
+            // Every element takes at least one byte: a forged count can't trigger a huge allocation
+            if (!reader.varint(count) || count > reader.remaining())
+                return false;
+            value.resize(static_cast<size_t>(count));
+            for (auto& element: value) {
+                if (!decodeValue(reader, element))
+                    return false;
+            }
+            return true;
+        } else if constexpr (detail::IsOptional<T>::value) {
+            bool present = false;
+            if (!reader.fixed(present))
+                return false;
+            if (!present) {
+                value.reset();
+                return true;
+            }
+            return decodeValue(reader, value.emplace());
+        } else {
+            static_assert(Described<T>, "BinaryCodec: the type is neither supported nor described");
+            bool decoded = true;
+            boost::mp11::mp_for_each<detail::Members<T>>([&](auto member) {
+                decoded = decoded && decodeValue(reader, value.*member.pointer);
+            });
+            return decoded;
+        }
+    }
+
+    // Lower bound of the encoded size, known at compile time: used to reserve the output
+    template <class T>
+    consteval size_t minEncodedSize()
+    {
+        if constexpr (detail::Fixed<T>) {
+            return sizeof(detail::Bits<T>);
+        } else if constexpr (Described<T>) {
+            size_t size = 0;
+            boost::mp11::mp_for_each<detail::Members<T>>([&](auto member) {
+                size += minEncodedSize<std::remove_cvref_t<decltype(std::declval<T&>().*member.pointer)>>();
+            });
+            return size;
+        } else {
+            // Varints, lengths, counts and presence flags
+            return 1;
+        }
+    }
+
+    // Appends the encoding of `value` to `out`
+    template <Described T>
+    void encode(const T& value, std::string& out)
+    {
+        out.reserve(out.size() + minEncodedSize<T>());
+        Writer writer { out };
+        encodeValue(writer, value);
+    }
+
+    template <Described T>
+    std::string encode(const T& value)
+    {
+        std::string out;
+        encode(value, out);
+        return out;
+    }
+
+    // Empty when the buffer is truncated, malformed or longer than the message
+    template <Described T>
+    std::optional<T> decode(asio::const_buffer buffer)
+    {
+        Reader reader { buffer };
+        std::optional<T> value { std::in_place };
+        if (!decodeValue(reader, *value) || reader.remaining() > 0)
+            return std::nullopt;
+        return value;
+    }
+
+    // A received WebSocket message. std::string_view fields stay valid until the buffer is consumed.
+    template <Described T>
+    std::optional<T> decode(const beast::flat_buffer& buffer) {
+        return decode<T>(buffer.cdata());
+    }
+}
+
+#endif //BOOSTPROJECTS_BINARYCODEC_H
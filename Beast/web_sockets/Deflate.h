@@ -0,0 +1,64 @@
+/**============================================================================
+Name        : Deflate.h
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : permessage-deflate (RFC 7692) settings shared by WebSocket servers and clients
+============================================================================**/
+
+#ifndef BOOSTPROJECTS_DEFLATE_H
+#define BOOSTPROJECTS_DEFLATE_H
+
+#include <cstddef>
+
+#include <boost/beast/core/role.hpp>
+#include <boost/beast/websocket/option.hpp>
+
+namespace Deflate
+{
+    namespace beast = boost::beast;
+    namespace websocket = beast::websocket;
+
+    struct Options
+    {
+        bool enabled { true };
+
+        // LZ77 window, 9..15 bits: the compression state kept per connection is about (1 << (windowBits + 2)) bytes
+        int windowBits { 15 };
+        // Hash table size, 1..9: memory per connection is about (1 << (memLevel + 9)) bytes
+        int memLevel { 8 };
+        // zlib compression level, 0..9
+        int compressionLevel { 6 };
+
+        // Without context takeover each message is compressed on its own: less memory held between messages,
+        // lower ratio on feeds where consecutive messages look alike
+        bool serverNoContextTakeover { false };
+        bool clientNoContextTakeover { false };
+
+        // Messages smaller than this are sent uncompressed
+        std::size_t minSize { 64 };
+    };
+
+    // Server: the extension is accepted when a client offers it. Client: the extension is offered.
+    inline websocket::permessage_deflate makeOption(const Options& options,
+                                                    beast::role_type role)
+    {
+        websocket::permessage_deflate deflate;
+        if (beast::role_type::server == role)
+            deflate.server_enable = options.enabled;
+        else
+            deflate.client_enable = options.enabled;
+
+        deflate.server_max_window_bits = options.windowBits;
+        deflate.client_max_window_bits = options.windowBits;
+        deflate.server_no_context_takeover = options.serverNoContextTakeover;
+        deflate.client_no_context_takeover = options.clientNoContextTakeover;
+        deflate.memLevel = options.memLevel;
+        deflate.compLevel = options.compressionLevel;
+        deflate.msg_size_threshold = options.minSize;
+        return deflate;
+    }
+}
+
+#endif //BOOSTPROJECTS_DEFLATE_H
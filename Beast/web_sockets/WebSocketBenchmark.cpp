@@ -0,0 +1,540 @@
+/**============================================================================
+Name        : WebSocketBenchmark.cpp
+Created on  : 19.10.2026
+Author      : Andrei Tokmakov
+Version     : 1.0
+Copyright   : Your copyright notice
+Description : WebSocket connection-scale benchmark client
+============================================================================**/
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <format>
+#include <print>
+#include <fstream>
+#include <optional>
+#include <atomic>
+#include <algorithm>
+#include <charconv>
+#include <bit>
+
+#include <sys/resource.h>
+#include <sys/types.h>
+
+#include <boost/asio.hpp>
+#include <boost/asio/as_tuple.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/experimental/awaitable_operators.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket.hpp>
+#include <boost/beast/websocket/ssl.hpp>
+#include <boost/program_options.hpp>
+
+namespace
+{
+    namespace asio = boost::asio;
+    namespace beast = boost::beast;
+    namespace websocket = beast::websocket;
+    namespace ssl = asio::ssl;
+    namespace po = boost::program_options;
+    using tcp = asio::ip::tcp;
+    using Clock = std::chrono::steady_clock;
+    using namespace asio::experimental::awaitable_operators;
+
+    // Connection errors are counted, only the first few are printed
+    constexpr uint64_t maxReportedErrors { 10 };
+    // Time left for the replies in flight once the load stops
+    constexpr std::chrono::seconds drainTime { 2 };
+
+    struct Config
+    {
+        std::string host { "127.0.0.1" };
+        uint16_t port { 6789 };
+        bool ssl { false };
+        uint32_t connections { 10'000 };
+        uint32_t threads { std::max(1U, std::thread::hardware_concurrency()) };
+        // New connections per second
+        uint32_t rampRate { 1'000 };
+        // Seconds of load once every connection is open
+        uint32_t duration { 30 };
+        // Echo messages per second, per connection
+        double rate { 1.0 };
+        uint32_t payloadSize { 64 };
+        // Broadcast latency: every connection subscribes to `topic` and one more connection publishes to it
+        std::string topic;
+        double broadcastRate { 10.0 };
+        // The server process, when it runs on this host: its resident memory gives the cost of a connection
+        pid_t serverPid { 0 };
+    };
+
+    // Log-linear histogram of nanosecond values: 32 sub-buckets per power of two, about 3% precision
+    class Histogram
+    {
+        static constexpr uint32_t subBucketBits { 5 };
+        static constexpr uint32_t subBuckets { 1U << subBucketBits };
+
+        std::array<uint64_t, subBuckets * 60> counts {};
+        uint64_t total { 0 };
+        uint64_t maxValue { 0 };
+
+        static size_t index(uint64_t value) noexcept
+        {
+            if (value < 2 * subBuckets)
+                return value;
+            const uint32_t shift = std::bit_width(value) - (subBucketBits + 1);
+            return shift * subBuckets + (value >> shift);
+        }
+
+        static uint64_t midpoint(size_t index) noexcept
+        {
+            if (index < 2 * subBuckets)
+                return index;
+            const uint32_t shift = index / subBuckets - 1;
+            const uint64_t lowest = (index - shift * subBuckets) << shift;
+            return lowest + (uint64_t { 1 } << shift) / 2;
+        }
+
+    public:
+        void record(std::chrono::nanoseconds value) noexcept
+        {
+            const uint64_t nanoseconds = std::max<int64_t>(0, value.count());
+            ++counts[index(nanoseconds)];
+            ++total;
+            maxValue = std::max(maxValue, nanoseconds);
+        }
+
+        void merge(const Histogram& other) noexcept
+        {
+            for (size_t i = 0; i < counts.size(); ++i)
+                counts[i] += other.counts[i];
+            total += other.total;
+            maxValue = std::max(maxValue, other.maxValue);
+        }
+
+        [[nodiscard]]
+        uint64_t percentile(double percent) const noexcept
+        {
+            const uint64_t rank = static_cast<uint64_t>(double(total) * percent / 100.0);
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts.size(); ++i)
+                if ((seen += counts[i]) > rank)
+                    return std::min(midpoint(i), maxValue);
+            return maxValue;
+        }
+
+        [[nodiscard]]
+        uint64_t count() const noexcept {
+            return total;
+        }
+
+        [[nodiscard]]
+        uint64_t max() const noexcept {
+            return maxValue;
+        }
+    };
+
+    // Connections currently open and failures, read by the progress report while the benchmark runs
+    struct Stats
+    {
+        std::atomic<uint64_t> open { 0 };
+        std::atomic<uint64_t> peak { 0 };
+        std::atomic<uint64_t> failed { 0 };
+    };
+
+    // One io_context per thread: its connections record into its own histograms, merged once all threads are done
+    struct Worker
+    {
+        asio::io_context ioContext { 1 };
+        asio::executor_work_guard<asio::io_context::executor_type> work { ioContext.get_executor() };
+        Histogram roundTrip;
+        Histogram broadcast;
+        uint64_t sent { 0 };
+        uint64_t received { 0 };
+        // Received messages carrying no timestamp: the server answers with something else than an echo
+        uint64_t unrecognized { 0 };
+    };
+
+    void fail(const beast::error_code& errorCode,
+              std::string_view what,
+              Stats& stats)
+    {
+        if (++stats.failed <= maxReportedErrors)
+            std::cerr << what << ": " << errorCode.message() << "\n";
+    }
+
+    std::optional<uint64_t> residentBytes(pid_t pid)
+    {
+        std::ifstream status { std::format("/proc/{}/status", pid) };
+        for (std::string line; std::getline(status, line);)
+        {
+            if (!line.starts_with("VmRSS:"))
+                continue;
+            const std::string_view value = std::string_view { line }.substr(line.find_first_of("0123456789"));
+            uint64_t kilobytes = 0;
+            std::from_chars(value.data(), value.data() + value.size(), kilobytes);
+            return kilobytes * 1024;
+        }
+        return std::nullopt;
+    }
+
+    // Tens of thousands of sockets need more than the usual soft limit of 1024 descriptors
+    void raiseFileLimit()
+    {
+        rlimit limit {};
+        if (0 == ::getrlimit(RLIMIT_NOFILE, &limit) && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+
+    int64_t parseNumber(std::string_view text) noexcept
+    {
+        int64_t value = 0;
+        std::from_chars(text.data(), text.data() + text.size(), value);
+        return value;
+    }
+
+    asio::awaitable<beast::error_code> secure(websocket::stream<beast::tcp_stream>&)
+    {
+        co_return beast::error_code {};
+    }
+
+    asio::awaitable<beast::error_code> secure(websocket::stream<ssl::stream<beast::tcp_stream>>& wsStream)
+    {
+        const auto [errorCode] = co_await wsStream.next_layer().async_handshake(ssl::stream_base::client, asio::as_tuple);
+        co_return errorCode;
+    }
+
+    template <class WsStream>
+    asio::awaitable<beast::error_code> open(WsStream& wsStream,
+                                           const Config& config,
+                                           const tcp::endpoint& endpoint)
+    {
+        beast::get_lowest_layer(wsStream).expires_after(std::chrono::seconds(30u));
+        if (const auto [errorCode] = co_await beast::get_lowest_layer(wsStream).async_connect(endpoint, asio::as_tuple); errorCode)
+            co_return errorCode;
+        if (const beast::error_code errorCode = co_await secure(wsStream))
+            co_return errorCode;
+
+        // The websocket stream has its own timeouts
+        beast::get_lowest_layer(wsStream).expires_never();
+        wsStream.set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
+
+        const auto [errorCode] = co_await wsStream.async_handshake(std::format("{}:{}", config.host, config.port), "/",
+                                                                   asio::as_tuple);
+        co_return errorCode;
+    }
+
+    // Opens a WS or WSS connection, depending on the configuration, and runs `body` over it
+    template <class Body>
+    asio::awaitable<void> with_connection(const Config& config,
+                                          ssl::context& ctx,
+                                          const tcp::endpoint& endpoint,
+                                          Stats& stats,
+                                          Body body)
+    {
+        const auto run = [&](auto& wsStream) -> asio::awaitable<void> {
+            if (const beast::error_code errorCode = co_await open(wsStream, config, endpoint)) {
+                fail(errorCode, "connect", stats);
+                co_return;
+            }
+
+            const uint64_t open = ++stats.open;
+            uint64_t peak = stats.peak.load();
+            while (open > peak && !stats.peak.compare_exchange_weak(peak, open))
+                ;
+
+            co_await body(wsStream);
+            --stats.open;
+            co_await wsStream.async_close(websocket::close_code::normal, asio::as_tuple);
+        };
+
+        const asio::any_io_executor executor = co_await asio::this_coro::executor;
+        if (config.ssl) {
+            websocket::stream<ssl::stream<beast::tcp_stream>> wsStream { executor, ctx };
+            co_await run(wsStream);
+        } else {
+            websocket::stream<beast::tcp_stream> wsStream { executor };
+            co_await run(wsStream);
+        }
+    }
+
+    // Echo replies come back as "rtt:<steady clock ns>:..." (CoroutineServer echoes the frame as it is) or
+    // "[rtt:<steady clock ns>:...]" (the chat servers wrap it), broadcasts as "bcast:<system clock ns>"
+    template <class WsStream>
+    asio::awaitable<void> read_loop(WsStream& wsStream,
+                                    Worker& worker)
+    {
+        beast::flat_buffer buffer;
+        while (true)
+        {
+            const auto [errorCode, bytesRead] = co_await wsStream.async_read(buffer, asio::as_tuple);
+            if (errorCode)
+                co_return;
+
+            std::string_view message { static_cast<const char*>(buffer.data().data()), buffer.size() };
+            if (message.starts_with('['))
+                message.remove_prefix(1);
+            if (message.starts_with("rtt:")) {
+                const Clock::duration sentAt { parseNumber(message.substr(4)) };
+                worker.roundTrip.record(Clock::now().time_since_epoch() - sentAt);
+            } else if (message.starts_with("bcast:")) {
+                // Wall clock: the publisher may run on another host, which then needs synchronized clocks
+                const std::chrono::nanoseconds sentAt { parseNumber(message.substr(6)) };
+                worker.broadcast.record(std::chrono::system_clock::now().time_since_epoch() - sentAt);
+            } else {
+                ++worker.unrecognized;
+            }
+            ++worker.received;
+            buffer.consume(buffer.size());
+        }
+    }
+
+    template <class WsStream>
+    asio::awaitable<void> write_loop(WsStream& wsStream,
+                                     const Config& config,
+                                     Worker& worker,
+                                     size_t index,
+                                     Clock::time_point stopAt)
+    {
+        asio::steady_timer timer { co_await asio::this_coro::executor };
+        if (config.rate <= 0.0)
+        {
+            timer.expires_at(stopAt + drainTime);
+            co_await timer.async_wait(asio::as_tuple);
+            co_return;
+        }
+
+        // Connections start at different offsets within the interval, so the load is not sent in bursts
+        const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / config.rate));
+        Clock::time_point next = Clock::now() + interval * (index % 1'000) / 1'000;
+
+        std::string message;
+        while (next < stopAt)
+        {
+            timer.expires_at(next);
+            if (const auto [errorCode] = co_await timer.async_wait(asio::as_tuple); errorCode)
+                co_return;
+
+            message = std::format("rtt:{}:", Clock::now().time_since_epoch().count());
+            message.resize(std::max<size_t>(message.size(), config.payloadSize), 'x');
+            if (const auto [errorCode, _] = co_await wsStream.async_write(asio::buffer(message), asio::as_tuple); errorCode)
+                co_return;
+            ++worker.sent;
+            next += interval;
+        }
+
+        timer.expires_after(drainTime);
+        co_await timer.async_wait(asio::as_tuple);
+    }
+
+    template <class WsStream>
+    asio::awaitable<void> publish_loop(WsStream& wsStream,
+                                       const Config& config,
+                                       Worker& worker,
+                                       Clock::time_point stopAt)
+    {
+        asio::steady_timer timer { co_await asio::this_coro::executor };
+        const auto interval = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(1.0 / config.broadcastRate));
+
+        std::string message;
+        for (Clock::time_point next = Clock::now(); next < stopAt; next += interval)
+        {
+            timer.expires_at(next);
+            if (const auto [errorCode] = co_await timer.async_wait(asio::as_tuple); errorCode)
+                co_return;
+
+            const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch());
+            message = std::format("publish:{}:bcast:{}", config.topic, now.count());
+            if (const auto [errorCode, _] = co_await wsStream.async_write(asio::buffer(message), asio::as_tuple); errorCode)
+                co_return;
+            ++worker.sent;
+        }
+
+        timer.expires_after(drainTime);
+        co_await timer.async_wait(asio::as_tuple);
+    }
+
+    asio::awaitable<void> connection(const Config& config,
+                                     ssl::context& ctx,
+                                     const tcp::endpoint& endpoint,
+                                     Stats& stats,
+                                     Worker& worker,
+                                     size_t index,
+                                     Clock::time_point stopAt)
+    {
+        co_await with_connection(config, ctx, endpoint, stats, [&, index, stopAt](auto& wsStream) -> asio::awaitable<void> {
+            if (!config.topic.empty())
+            {
+                const std::string subscribe = "subscribe:" + config.topic;
+                if (const auto [errorCode, _] = co_await wsStream.async_write(asio::buffer(subscribe), asio::as_tuple); errorCode)
+                    co_return;
+            }
+            co_await (read_loop(wsStream, worker) || write_loop(wsStream, config, worker, index, stopAt));
+        });
+    }
+
+    asio::awaitable<void> publisher(const Config& config,
+                                    ssl::context& ctx,
+                                    const tcp::endpoint& endpoint,
+                                    Stats& stats,
+                                    Worker& worker,
+                                    Clock::time_point stopAt)
+    {
+        co_await with_connection(config, ctx, endpoint, stats, [&, stopAt](auto& wsStream) -> asio::awaitable<void> {
+            // Reading keeps control frames flowing, the publisher receives no data
+            co_await (read_loop(wsStream, worker) || publish_loop(wsStream, config, worker, stopAt));
+        });
+    }
+
+    void report(std::string_view name,
+                const Histogram& histogram)
+    {
+        if (0 == histogram.count())
+            return;
+        const auto ms = [](uint64_t nanoseconds) { return double(nanoseconds) / 1'000'000.0; };
+        std::println("{:<12} n={:<10} p50 {:>8.3f} ms  p90 {:>8.3f} ms  p99 {:>8.3f} ms  p99.9 {:>8.3f} ms  max {:>8.3f} ms",
+                     name, histogram.count(), ms(histogram.percentile(50)), ms(histogram.percentile(90)),
+                     ms(histogram.percentile(99)), ms(histogram.percentile(99.9)), ms(histogram.max()));
+    }
+
+    std::optional<Config> parseOptions(int argc, char** argv)
+    {
+        Config config;
+        po::options_description description { "WebSocket benchmark options" };
+        description.add_options()
+                ("help", "produce help message")
+                ("host", po::value(&config.host)->default_value(config.host), "server address")
+                ("port", po::value(&config.port)->default_value(config.port), "server port")
+                ("ssl", po::bool_switch(&config.ssl), "connect with WSS")
+                ("connections", po::value(&config.connections)->default_value(config.connections), "concurrent connections")
+                ("threads", po::value(&config.threads)->default_value(config.threads), "client I/O threads")
+                ("ramp", po::value(&config.rampRate)->default_value(config.rampRate), "new connections per second")
+                ("duration", po::value(&config.duration)->default_value(config.duration), "seconds of load after the ramp")
+                ("rate", po::value(&config.rate)->default_value(config.rate), "echo messages per second per connection")
+                ("payload", po::value(&config.payloadSize)->default_value(config.payloadSize), "echo message size")
+                ("topic", po::value(&config.topic), "subscribe every connection and publish to this topic")
+                ("broadcast-rate", po::value(&config.broadcastRate)->default_value(config.broadcastRate), "publishes per second")
+                ("server-pid", po::value(&config.serverPid), "server process id, to sample its memory (same host only)");
+
+        po::variables_map options;
+        po::store(po::parse_command_line(argc, argv, description), options);
+        po::notify(options);
+        if (options.count("help")) {
+            std::cout << description << "\n";
+            return std::nullopt;
+        }
+        config.threads = std::max(1U, config.threads);
+        config.rampRate = std::max(1U, config.rampRate);
+        return config;
+    }
+}
+
+// WebSocketBenchmark --connections 20000 --rate 1 --topic prices --server-pid $(pidof Beast)
+int main(int argc, char** argv)
+{
+    try
+    {
+        const std::optional<Config> parsed = parseOptions(argc, argv);
+        if (!parsed)
+            return EXIT_SUCCESS;
+        const Config& config = *parsed;
+
+        raiseFileLimit();
+        ssl::context ctx { ssl::context::tlsv13_client };
+        ctx.set_verify_mode(ssl::verify_none);
+
+        tcp::endpoint endpoint;
+        {
+            asio::io_context ioCtx;
+            endpoint = *tcp::resolver { ioCtx }.resolve(config.host, std::to_string(config.port)).begin();
+        }
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        for (uint32_t i = 0; i < config.threads; ++i)
+            workers.push_back(std::make_unique<Worker>());
+        std::vector<std::jthread> runners;
+        for (const std::unique_ptr<Worker>& worker: workers)
+            runners.emplace_back([&ioContext = worker->ioContext] { ioContext.run(); });
+
+        Stats stats;
+        const std::optional<uint64_t> rssBefore = config.serverPid ? residentBytes(config.serverPid) : std::nullopt;
+
+        const Clock::time_point start = Clock::now();
+        const auto rampTime = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(double(config.connections) / config.rampRate));
+        const Clock::time_point stopAt = start + rampTime + std::chrono::seconds(config.duration);
+
+        if (!config.topic.empty())
+            asio::co_spawn(workers.front()->ioContext,
+                           publisher(config, ctx, endpoint, stats, *workers.front(), stopAt), asio::detached);
+
+        Clock::time_point nextReport = start + std::chrono::seconds(1);
+        for (uint32_t i = 0; i < config.connections; ++i)
+        {
+            std::this_thread::sleep_until(start + rampTime * i / config.connections);
+            Worker& worker = *workers[i % workers.size()];
+            asio::co_spawn(worker.ioContext, connection(config, ctx, endpoint, stats, worker, i, stopAt), asio::detached);
+
+            if (Clock::now() >= nextReport) {
+                std::println("ramp: {} open, {} failed", stats.open.load(), stats.failed.load());
+                nextReport += std::chrono::seconds(1);
+            }
+        }
+
+        // Every connection is open now (or failed): the server memory is sampled at its peak
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        const uint64_t connected = stats.open.load();
+        const std::optional<uint64_t> rssLoaded = config.serverPid ? residentBytes(config.serverPid) : std::nullopt;
+        std::println("load: {} open, {} failed", connected, stats.failed.load());
+
+        std::this_thread::sleep_until(stopAt + 2 * drainTime);
+        for (const std::unique_ptr<Worker>& worker: workers) {
+            worker->work.reset();
+            worker->ioContext.stop();
+        }
+        runners.clear();
+
+        Worker total;
+        for (const std::unique_ptr<Worker>& worker: workers)
+        {
+            total.roundTrip.merge(worker->roundTrip);
+            total.broadcast.merge(worker->broadcast);
+            total.sent += worker->sent;
+            total.received += worker->received;
+            total.unrecognized += worker->unrecognized;
+        }
+
+        std::println("connections: peak {}, failed {}", stats.peak.load(), stats.failed.load());
+        std::println("messages:    sent {}, received {}", total.sent, total.received);
+        report("round trip", total.roundTrip);
+        report("broadcast", total.broadcast);
+        if (total.received > 0 && 0 == total.roundTrip.count() && 0 == total.broadcast.count())
+            std::println("latency:     none of the {} received messages is an \"rtt:\" or \"bcast:\" reply", total.received);
+        else if (total.unrecognized > 0)
+            std::println("latency:     {} received messages without a timestamp were not measured", total.unrecognized);
+        if (rssBefore && rssLoaded && connected > 0)
+        {
+            const int64_t delta = int64_t(*rssLoaded) - int64_t(*rssBefore);
+            std::println("server:      {:.1f} KB per connection ({:.1f} MB for {} connections)",
+                         double(delta) / 1024.0 / double(connected), double(delta) / (1024.0 * 1024.0), connected);
+        }
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
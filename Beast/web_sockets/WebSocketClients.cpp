@@ -45,8 +45,9 @@ Description : WebSocketClients.cpp
 #include <boost/asio/ssl.hpp>
 
 #include "server_certificate.hpp"
-#include "root_certificates.hpp"
+#include "trust_store.hpp"
 #include "Utilities.h"
+#include "Deflate.h"
 
 namespace
 {
@@ -87,6 +88,7 @@ namespace SimpleClient
         wsStream.set_option(websocket::stream_base::decorator([](websocket::request_type& req){
             req.set(http::field::user_agent,std::string(BOOST_BEAST_VERSION_STRING) +" websocket-client-coro");
         }));
+        wsStream.set_option(Deflate::makeOption(Deflate::Options {}, beast::role_type::client));
 
         wsStream.handshake(host + ':' + std::to_string(port), "/chargeStationState");
 
@@ -118,7 +120,7 @@ namespace SslClient
         ssl::context sslCtx { ssl::context::tlsv13_client };
 
         // This holds the root certificate used for verification
-        // load_root_certificates(sslCtx);
+        // load_shared_root_certificates(sslCtx);
 
         tcp::resolver resolver { ioCtx };
         websocket::stream<ssl::stream<tcp::socket>> wsStream { ioCtx, sslCtx };
@@ -139,6 +141,7 @@ namespace SslClient
         wsStream.set_option(websocket::stream_base::decorator([](websocket::request_type& req){
             req.set(http::field::user_agent,std::string(BOOST_BEAST_VERSION_STRING) +" websocket-client-coro");
         }));
+        wsStream.set_option(Deflate::makeOption(Deflate::Options {}, beast::role_type::client));
 
         wsStream.handshake(host + ':' + std::to_string(port), "/chargeStatissonState");
 
@@ -246,6 +249,9 @@ namespace AsyncSslClient
                 req.set(http::field::user_agent, std::string(BOOST_BEAST_VERSION_STRING) + " websocket-client-async-ssl");
             }));
 
+            // Offer permessage-deflate, the server decides whether it is used
+            wsStream.set_option(Deflate::makeOption(Deflate::Options {}, beast::role_type::client));
+
             // Perform the websocket handshake
             wsStream.async_handshake(host, "/",
                     beast::bind_front_handler(&Session::on_handshake, shared_from_this()));
@@ -314,7 +320,7 @@ namespace AsyncSslClient
         ssl::context ctx{ssl::context::tlsv13_client};
 
         // This holds the root certificate used for verification
-        // load_root_certificates(ctx);
+        // load_shared_root_certificates(ctx);
 
         // Launch the asynchronous operation
         std::make_shared<Session>(ioCtx, ctx)->run(host, port, text);
@@ -19,6 +19,21 @@ Description : WebSocketServers.cpp
 #include <print>
 #include <chrono>
 #include <typeindex>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <array>
+#include <random>
+#include <charconv>
+#include <optional>
+#include <limits>
+#include <bit>
 
 #include <boost/asio.hpp>
 #include <boost/asio/experimental/awaitable_operators.hpp>
@@ -41,12 +56,17 @@ Description : WebSocketServers.cpp
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/beast/websocket/ssl.hpp>
+#include <boost/beast/_experimental/test/stream.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ssl.hpp>
+#include <boost/describe.hpp>
+#include <boost/json.hpp>
 
 #include "server_certificate.hpp"
 #include "root_certificates.hpp"
 #include "Utilities.h"
+#include "Deflate.h"
+#include "BinaryCodec.h"
 
 namespace
 {
@@ -80,6 +100,7 @@ namespace SimpleServer
             wsStream.set_option(websocket::stream_base::decorator([](websocket::response_type& res){
                 res.set(http::field::server, std::string(BOOST_BEAST_VERSION_STRING) + " websocket-server-sync");
             }));
+            wsStream.set_option(Deflate::makeOption(Deflate::Options {}, beast::role_type::server));
 
             // Accept the websocket handshake
             wsStream.accept();
@@ -157,6 +178,7 @@ namespace SSLServer
             wsStream.set_option(websocket::stream_base::decorator([](websocket::response_type& res){
                 res.set(http::field::server, std::string(BOOST_BEAST_VERSION_STRING) + " websocket-server-sync-ssl");
             }));
+            wsStream.set_option(Deflate::makeOption(Deflate::Options {}, beast::role_type::server));
 
             // Accept the websocket handshake
             wsStream.accept();
@@ -217,18 +239,706 @@ namespace SSLServer
     }
 }
 
+// SimpleServer and SSLServer semantics without a thread per connection: every session is a coroutine
+// on a fixed pool of threads, so a connection costs a coroutine frame and its buffers instead of a thread stack
+namespace CoroutineServer
+{
+    constexpr std::string_view host { "0.0.0.0" };
+    constexpr uint16_t port { 6789 };
+    constexpr uint32_t threads { 4 };
+    // Pause of the accept loop when the process is out of descriptors or memory
+    constexpr std::chrono::milliseconds acceptBackoff { 100 };
+
+    template <class Stream>
+    asio::awaitable<void> echo(websocket::stream<Stream>& wsStream)
+    {
+        // One buffer per session, reused for every message
+        beast::flat_buffer buffer;
+        while (true)
+        {
+            const auto [readError, bytesRead] = co_await wsStream.async_read(buffer, asio::as_tuple);
+            // This indicates that the session was closed
+            if (websocket::error::closed == readError)
+                co_return;
+            if (readError) {
+                fail(readError, "read");
+                co_return;
+            }
+
+            // Echo the message back
+            wsStream.text(wsStream.got_text());
+            const auto [writeError, bytesWritten] = co_await wsStream.async_write(buffer.data(), asio::as_tuple);
+            if (writeError) {
+                fail(writeError, "write");
+                co_return;
+            }
+            buffer.consume(buffer.size());
+        }
+    }
+
+    template <class Stream>
+    void configure(websocket::stream<Stream>& wsStream,
+                   std::string_view serverName)
+    {
+        wsStream.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+        wsStream.set_option(websocket::stream_base::decorator([serverName](websocket::response_type& res) {
+            res.set(http::field::server, std::string(BOOST_BEAST_VERSION_STRING).append(" ").append(serverName));
+        }));
+        wsStream.set_option(Deflate::makeOption(Deflate::Options {}, beast::role_type::server));
+    }
+
+    asio::awaitable<void> session(tcp::socket socket)
+    {
+        websocket::stream<beast::tcp_stream> wsStream { std::move(socket) };
+        configure(wsStream, "websocket-server-coro");
+
+        const auto [errorCode] = co_await wsStream.async_accept(asio::as_tuple);
+        if (errorCode) {
+            fail(errorCode, "accept");
+            co_return;
+        }
+        co_await echo(wsStream);
+    }
+
+    asio::awaitable<void> sslSession(tcp::socket socket,
+                                     ssl::context& ctx)
+    {
+        websocket::stream<ssl::stream<beast::tcp_stream>> wsStream { std::move(socket), ctx };
+
+        // The websocket stream has its own timeouts, the TCP one only guards the TLS handshake
+        beast::get_lowest_layer(wsStream).expires_after(std::chrono::seconds(30u));
+        const auto [handshakeError] = co_await wsStream.next_layer().async_handshake(ssl::stream_base::server,
+                                                                                      asio::as_tuple);
+        if (handshakeError) {
+            fail(handshakeError, "handshake");
+            co_return;
+        }
+        beast::get_lowest_layer(wsStream).expires_never();
+        configure(wsStream, "websocket-server-coro-ssl");
+
+        const auto [acceptError] = co_await wsStream.async_accept(asio::as_tuple);
+        if (acceptError) {
+            fail(acceptError, "accept");
+            co_return;
+        }
+        co_await echo(wsStream);
+    }
+
+    // `ctx` is nullptr for plain WebSocket
+    asio::awaitable<void> listen(tcp::acceptor acceptor,
+                                 ssl::context* ctx)
+    {
+        const asio::any_io_executor executor = co_await asio::this_coro::executor;
+        asio::steady_timer backoff { executor };
+        while (true)
+        {
+            // A strand per connection: the stream's internal timers and the session never run concurrently
+            auto [errorCode, socket] = co_await acceptor.async_accept(asio::make_strand(executor), asio::as_tuple);
+            if (errorCode)
+            {
+                fail(errorCode, "accept");
+                if (asio::error::connection_aborted == errorCode)
+                    continue;
+                // Out of descriptors or memory: the pending connection stays queued, retrying at once would spin
+                if (asio::error::no_descriptors == errorCode || asio::error::no_buffer_space == errorCode ||
+                    asio::error::no_memory == errorCode ||
+                    boost::system::errc::too_many_files_open_in_system == errorCode)
+                {
+                    backoff.expires_after(acceptBackoff);
+                    co_await backoff.async_wait(asio::as_tuple);
+                    continue;
+                }
+                // Like the Listener of the asynchronous servers: any other error ends the accept loop
+                co_return;
+            }
+
+            const asio::any_io_executor strand = socket.get_executor();
+            if (nullptr == ctx)
+                asio::co_spawn(strand, session(std::move(socket)), asio::detached);
+            else
+                asio::co_spawn(strand, sslSession(std::move(socket), *ctx), asio::detached);
+        }
+    }
+
+    void runServer(bool useSsl)
+    {
+        try
+        {
+            asio::io_context ioCtx { threads };
+            ssl::context ctx { ssl::context::tlsv13 };
+            if (useSsl)
+                load_server_certificate(ctx);
+
+            tcp::acceptor acceptor { ioCtx, { asio::ip::make_address(host), port } };
+            asio::co_spawn(ioCtx, listen(std::move(acceptor), useSsl ? &ctx : nullptr), [](std::exception_ptr e) {
+                if (e) {
+                    std::rethrow_exception(e);
+                }
+            });
+
+            std::vector<std::jthread> workers;
+            workers.reserve(threads - 1);
+            for (uint32_t n = 1; n < threads; ++n)
+                workers.emplace_back([&ioCtx] { ioCtx.run(); });
+            ioCtx.run();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
 namespace SSL_Asynch_Server
 {
+    constexpr std::string_view echoPrefix { "[" };
+    constexpr std::string_view echoSuffix { "]" };
+
+    class Session;
+
+    // A published payload: serialized once, then shared read-only by the write queue of every recipient
+    using Message = std::shared_ptr<const std::string>;
+
+    struct Outbound
+    {
+        Message payload;
+        // Conflation key (the topic for published messages), nullptr when the message can not be conflated
+        Message key;
+        bool text { true };
+    };
+
+    // What a session does when a slow consumer lets its queue fill up
+    enum class OverflowPolicy
+    {
+        DropOldest,
+        DropNewest,
+        // A queued message with the same key is replaced by the newer one, wherever the queue stands.
+        // A full queue then drops the newest message.
+        ConflateByKey,
+        Disconnect
+    };
+
+    struct QueueOptions
+    {
+        size_t capacity { 1024 };
+        OverflowPolicy policy { OverflowPolicy::DropOldest };
+        // When non-zero, consecutive queued text messages are joined with '\n' into one message of up to that
+        // many bytes. Only for protocols such as NDJSON feeds, where clients split on newlines themselves.
+        size_t coalesceBytes { 0 };
+    };
+
+    // Shared by every session of a server
+    struct QueueMetrics
+    {
+        // Messages waiting in all queues, and the deepest single queue seen
+        std::atomic<int64_t> depth { 0 };
+        std::atomic<uint64_t> maxDepth { 0 };
+
+        std::atomic<uint64_t> enqueued { 0 };
+        std::atomic<uint64_t> written { 0 };
+        std::atomic<uint64_t> dropped { 0 };
+        std::atomic<uint64_t> conflated { 0 };
+        std::atomic<uint64_t> coalesced { 0 };
+        std::atomic<uint64_t> disconnects { 0 };
+
+        [[nodiscard]]
+        std::string toJson(size_t sessionDepth) const
+        {
+            return std::format(R"({{"depth":{},"maxDepth":{},"sessionDepth":{},"enqueued":{},"written":{},)"
+                               R"("dropped":{},"conflated":{},"coalesced":{},"disconnects":{}}})",
+                               depth.load(), maxDepth.load(), sessionDepth, enqueued.load(), written.load(),
+                               dropped.load(), conflated.load(), coalesced.load(), disconnects.load());
+        }
+    };
+
+    // Bounded queue of one session. Not thread-safe: it's only used on the session strand.
+    class OutboundQueue
+    {
+        std::deque<Outbound> items;
+        const QueueOptions& options;
+        QueueMetrics& metrics;
+
+    public:
+        enum class Result
+        {
+            Queued,
+            Conflated,
+            Dropped,
+            Overflow
+        };
+
+        OutboundQueue(const QueueOptions& options,
+                      QueueMetrics& metrics): options { options }, metrics { metrics } {
+        }
+
+        ~OutboundQueue() {
+            metrics.depth -= static_cast<int64_t>(items.size());
+        }
+
+        OutboundQueue(const OutboundQueue&) = delete;
+        OutboundQueue& operator=(const OutboundQueue&) = delete;
+
+        Result push(Outbound message)
+        {
+            if (OverflowPolicy::ConflateByKey == options.policy && message.key)
+            {
+                const auto same = std::ranges::find_if(items, [&message](const Outbound& queued) {
+                    return queued.key && *queued.key == *message.key;
+                });
+                if (items.end() != same) {
+                    same->payload = std::move(message.payload);
+                    ++metrics.conflated;
+                    return Result::Conflated;
+                }
+            }
+
+            if (items.size() >= options.capacity)
+            {
+                switch (options.policy)
+                {
+                    case OverflowPolicy::DropOldest:
+                        items.pop_front();
+                        --metrics.depth;
+                        ++metrics.dropped;
+                        break;
+                    case OverflowPolicy::DropNewest:
+                    case OverflowPolicy::ConflateByKey:
+                        ++metrics.dropped;
+                        return Result::Dropped;
+                    case OverflowPolicy::Disconnect:
+                        ++metrics.disconnects;
+                        return Result::Overflow;
+                }
+            }
+
+            items.push_back(std::move(message));
+            ++metrics.depth;
+            ++metrics.enqueued;
+
+            uint64_t deepest = metrics.maxDepth.load(std::memory_order::relaxed);
+            while (items.size() > deepest && !metrics.maxDepth.compare_exchange_weak(deepest, items.size()))
+                ;
+            return Result::Queued;
+        }
+
+        [[nodiscard]]
+        const Outbound& front() const noexcept {
+            return items.front();
+        }
+
+        Outbound pop()
+        {
+            Outbound message = std::move(items.front());
+            items.pop_front();
+            --metrics.depth;
+            return message;
+        }
+
+        [[nodiscard]]
+        bool empty() const noexcept {
+            return items.empty();
+        }
+
+        [[nodiscard]]
+        size_t size() const noexcept {
+            return items.size();
+        }
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    struct HeartbeatOptions
+    {
+        // One timer for the whole server: every tick pings each session and reaps the dead ones
+        std::chrono::seconds interval { 10 };
+        // A session that neither answered a ping nor sent anything for that long is dead
+        std::chrono::seconds timeout { 30 };
+        // Dead sessions closed per tick: a network outage should not turn into a burst of thousands of closes
+        size_t reapBatch { 256 };
+        // Subscribers with a smoothed RTT above that get published messages after the others
+        std::chrono::milliseconds slowRtt { 200 };
+    };
+
+    struct FileOptions
+    {
+        // "file:<name>" streams <root>/<name>
+        std::string root { "/tmp/www" };
+        size_t chunkSize { 256 * 1024 };
+        // Read-ahead of one transfer: disk reads run while the previous chunks are being written
+        size_t chunksPerTransfer { 4 };
+        // Every transfer of the server takes its chunks from this many: memory stays at poolChunks * chunkSize
+        size_t poolChunks { 64 };
+    };
+
+    struct SessionOptions
+    {
+        QueueOptions queue;
+        Deflate::Options deflate;
+        HeartbeatOptions heartbeat;
+        FileOptions files;
+    };
+
+#if defined(BOOST_ASIO_HAS_FILE)
+    // Backed by io_uring on Linux (BOOST_ASIO_HAS_IO_URING)
+    using File = asio::stream_file;
+#else
+    // Blocking fallback when Asio is built without file support
+    using File = beast::file;
+#endif
+
+    // Fixed set of chunk buffers, reused by all the file transfers of the server
+    class ChunkPool
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<char[]>> chunks;
+
+    public:
+        const size_t chunkSize;
+
+        ChunkPool(size_t chunkSize,
+                  size_t chunkCount): chunkSize { chunkSize }
+        {
+            chunks.reserve(chunkCount);
+            for (size_t i = 0; i < chunkCount; ++i)
+                chunks.push_back(std::make_unique<char[]>(chunkSize));
+        }
+
+        // nullptr when every chunk is in use
+        std::unique_ptr<char[]> acquire()
+        {
+            std::lock_guard lock { mutex };
+            if (chunks.empty())
+                return nullptr;
+            std::unique_ptr<char[]> chunk = std::move(chunks.back());
+            chunks.pop_back();
+            return chunk;
+        }
+
+        void release(std::unique_ptr<char[]> chunk)
+        {
+            std::lock_guard lock { mutex };
+            chunks.push_back(std::move(chunk));
+        }
+    };
+
+    // A file sent as one binary message: chunks cycle free -> read from disk -> filled -> written as a frame -> free
+    struct FileTransfer
+    {
+        struct Chunk
+        {
+            std::unique_ptr<char[]> data;
+            size_t size { 0 };
+        };
+
+        ChunkPool& pool;
+        File file;
+        std::vector<Chunk> chunks;
+        std::deque<size_t> free;
+        std::deque<size_t> filled;
+        std::string name;
+        uint64_t sent { 0 };
+        Clock::time_point started { Clock::now() };
+        bool reading { false };
+        bool eof { false };
+
+        FileTransfer(ChunkPool& pool,
+                     File&& file,
+                     std::string_view name): pool { pool }, file { std::move(file) }, name { name } {
+        }
+
+        ~FileTransfer()
+        {
+            for (Chunk& chunk: chunks)
+                pool.release(std::move(chunk.data));
+        }
+    };
+
+    // Ping round trips of every session: power-of-two buckets in microseconds, recorded from any strand
+    class RttHistogram
+    {
+        static constexpr size_t bucketCount { 32 };
+        std::array<std::atomic<uint64_t>, bucketCount> buckets {};
+
+    public:
+        void record(Clock::duration rtt) noexcept
+        {
+            const uint64_t micros = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(rtt).count());
+            buckets[std::min<size_t>(std::bit_width(micros), bucketCount - 1)].fetch_add(1, std::memory_order::relaxed);
+        }
+
+        // Upper bound of the bucket holding the percentile, in microseconds
+        [[nodiscard]]
+        uint64_t percentile(double percent) const noexcept
+        {
+            std::array<uint64_t, bucketCount> counts {};
+            uint64_t total = 0;
+            for (size_t i = 0; i < bucketCount; ++i)
+                total += counts[i] = buckets[i].load(std::memory_order::relaxed);
+
+            const uint64_t rank = static_cast<uint64_t>(double(total) * percent / 100.0);
+            uint64_t seen = 0;
+            for (size_t i = 0; i < bucketCount; ++i)
+                if (counts[i] > 0 && (seen += counts[i]) > rank)
+                    return uint64_t { 1 } << i;
+            return 0;
+        }
+
+        // Bucket i counts the round trips in [2^(i-1), 2^i) microseconds
+        [[nodiscard]]
+        std::string toJson() const
+        {
+            std::string counts;
+            for (const std::atomic<uint64_t>& bucket: buckets)
+                std::format_to(std::back_inserter(counts), "{}{}", counts.empty() ? "" : ",", bucket.load());
+            return std::format(R"({{"p50":{},"p90":{},"p99":{},"buckets":[{}]}})",
+                               percentile(50), percentile(90), percentile(99), counts);
+        }
+    };
+
+    // Pings every session on a shared coarse timer, instead of a timer per session, and reaps dead connections
+    class Heartbeat
+    {
+        const HeartbeatOptions& options;
+        asio::steady_timer timer;
+        std::mutex mutex;
+        std::vector<std::weak_ptr<Session>> sessions;
+
+        void schedule();
+        void tick();
+
+    public:
+        RttHistogram rtt;
+        std::atomic<uint64_t> live { 0 };
+        std::atomic<uint64_t> pings { 0 };
+        std::atomic<uint64_t> pongs { 0 };
+        std::atomic<uint64_t> reaped { 0 };
+
+        Heartbeat(asio::io_context& ioc,
+                  const HeartbeatOptions& options): options { options }, timer { asio::make_strand(ioc) } {
+        }
+
+        void start() {
+            schedule();
+        }
+
+        void add(const std::shared_ptr<Session>& session)
+        {
+            std::lock_guard lock { mutex };
+            sessions.push_back(session);
+        }
+
+        [[nodiscard]]
+        std::string toJson() const
+        {
+            return std::format(R"({{"sessions":{},"pings":{},"pongs":{},"reaped":{},"rttUs":{}}})",
+                               live.load(), pings.load(), pongs.load(), reaped.load(), rtt.toJson());
+        }
+    };
+
+    struct StringHash
+    {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view value) const noexcept {
+            return std::hash<std::string_view> {}(value);
+        }
+    };
+
+    // Vyukov's intrusive MPSC queue: producers on any thread push with one atomic exchange, one consumer pops
+    template <class T>
+    class MpscQueue
+    {
+        struct Node
+        {
+            std::atomic<Node*> next { nullptr };
+            T value;
+        };
+
+        std::atomic<Node*> head;
+        Node* tail;
+        Node stub;
+
+    public:
+        MpscQueue(): head { &stub }, tail { &stub } {
+        }
+
+        ~MpscQueue() {
+            while (pop())
+                ;
+        }
+
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        void push(T value) {
+            push(new Node { nullptr, std::move(value) });
+        }
+
+        // Consumer only. Also empty while a producer is between its exchange and its link: it then retries.
+        std::optional<T> pop()
+        {
+            Node* first = tail;
+            Node* next = first->next.load(std::memory_order::acquire);
+            if (&stub == first)
+            {
+                if (nullptr == next)
+                    return std::nullopt;
+                tail = first = next;
+                next = next->next.load(std::memory_order::acquire);
+            }
+            if (nullptr == next)
+            {
+                if (head.load(std::memory_order::acquire) != first)
+                    return std::nullopt;
+                // `first` is the last node: the stub goes behind it, so it can be unlinked
+                push(&stub);
+                next = first->next.load(std::memory_order::acquire);
+                if (nullptr == next)
+                    return std::nullopt;
+            }
+            tail = next;
+            std::optional<T> value { std::move(first->value) };
+            delete first;
+            return value;
+        }
+
+        // Consumer only
+        [[nodiscard]]
+        bool empty() const noexcept {
+            return &stub == tail && nullptr == stub.next.load(std::memory_order::acquire)
+                   && &stub == head.load(std::memory_order::acquire);
+        }
+
+    private:
+        void push(Node* node)
+        {
+            node->next.store(nullptr, std::memory_order::relaxed);
+            Node* previous = head.exchange(node, std::memory_order::acq_rel);
+            previous->next.store(node, std::memory_order::release);
+        }
+    };
+
+    // Sessions and rooms partitioned by shard. A shard is a strand: the sessions accepted on it run on that strand,
+    // so joining, leaving and delivering to its rooms need no lock. Publishes to other shards go through their
+    // inboxes, drained by one post per batch rather than one per message.
+    class Registry
+    {
+    public:
+        class Shard
+        {
+            friend Registry;
+            using Members = std::vector<std::weak_ptr<Session>>;
+
+            // A publish headed for the rooms of this shard
+            struct Delivery
+            {
+                Message topic;
+                Message payload;
+            };
+
+            // Deliveries handled per drain before yielding to the sessions of the shard
+            static constexpr size_t drainBatch { 1024 };
+
+            asio::strand<asio::io_context::executor_type> strand;
+            // On the strand only
+            std::unordered_map<std::string, Members, StringHash, std::equal_to<>> rooms;
+            MpscQueue<Delivery> inbox;
+            std::atomic<bool> scheduled { false };
+
+            void deliver(const Delivery& delivery);
+            void enqueue(Delivery delivery);
+            void drain();
+
+        public:
+            explicit Shard(asio::io_context& ioc): strand { asio::make_strand(ioc) } {
+            }
+
+            [[nodiscard]]
+            const asio::strand<asio::io_context::executor_type>& executor() const noexcept {
+                return strand;
+            }
+        };
+
+    private:
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::atomic<size_t> nextShard { 0 };
+
+    public:
+        Registry(asio::io_context& ioc,
+                 size_t shardCount)
+        {
+            shards.reserve(shardCount);
+            for (size_t i = 0; i < shardCount; ++i)
+                shards.push_back(std::make_unique<Shard>(ioc));
+        }
+
+        // Round-robin placement of a new connection
+        Shard& assign() noexcept {
+            return *shards[nextShard.fetch_add(1, std::memory_order::relaxed) % shards.size()];
+        }
+
+        // join, leave and publish are called on the strand of `shard`, the one of the calling session
+        void join(Shard& shard,
+                  std::string_view topic,
+                  const std::shared_ptr<Session>& session);
+
+        void leave(Shard& shard,
+                   std::string_view topic,
+                   const Session* session);
+
+        void publish(Shard& shard,
+                     std::string_view topic,
+                     std::string_view payload);
+    };
+
     class Session : public std::enable_shared_from_this<Session>
     {
         websocket::stream<ssl::stream<beast::tcp_stream>> wsStream;
         beast::flat_buffer buffer;
+        Registry& registry;
+        // Runs every handler of the session: its socket was accepted on the shard strand
+        Registry::Shard& shard;
+        Heartbeat& heartbeat;
+        ChunkPool& chunkPool;
+        const SessionOptions& options;
+        QueueMetrics& queueMetrics;
+
+        // Read by the heartbeat and by the shards publishing to this session
+        std::atomic<Clock::rep> lastSeen { Clock::now().time_since_epoch().count() };
+        std::atomic<Clock::rep> smoothedRtt { -1 };
+        bool pingPending { false };
+
+        // One writer drains the queue: `current` or `batch` holds what is being written
+        OutboundQueue sendQueue;
+        Message current;
+        std::string batch;
+        std::unordered_set<std::string> topics;
+        bool writing { false };
+        bool closed { false };
+        // The echo is written straight from `buffer`, so reading resumes once that write completes
+        bool echoPending { false };
+        bool echoing { false };
+        // Owns the write side while it streams: queued messages and echoes wait for the end of the file
+        std::unique_ptr<FileTransfer> transfer;
+        static constexpr size_t noChunk { std::numeric_limits<size_t>::max() };
 
     public:
-        Session(tcp::socket&& socket, ssl::context& ctx)
-            : wsStream(std::move(socket), ctx) {
+        Session(tcp::socket&& socket,
+                ssl::context& ctx,
+                Registry& registry,
+                Registry::Shard& shard,
+                Heartbeat& heartbeat,
+                ChunkPool& chunkPool,
+                const SessionOptions& options,
+                QueueMetrics& queueMetrics)
+            : wsStream(std::move(socket), ctx), registry { registry }, shard { shard }, heartbeat { heartbeat },
+              chunkPool { chunkPool }, options { options },
+              queueMetrics { queueMetrics }, sendQueue { options.queue, queueMetrics } {
         }
 
+        // No unsubscribe on destruction: the last reference may be released off the shard strand,
+        // and the rooms hold weak references that are pruned as they expire
+
         void run()
         {   // We need to be executing within a strand to perform async operations on the I/O objects in this session.
             // Although not strictly necessary for single-threaded contexts, this example code is written to be
@@ -237,6 +947,67 @@ namespace SSL_Asynch_Server
                 beast::bind_front_handler(&Session::on_run, shared_from_this()));
         }
 
+        // May be called from any thread: the message is queued on the session strand.
+        // Deliveries from the own shard are already there and run inline.
+        void send(Outbound message)
+        {
+            asio::dispatch(wsStream.get_executor(), [self = shared_from_this(), message = std::move(message)]() mutable {
+                if (self->closed)
+                    return;
+                if (OutboundQueue::Result::Overflow == self->sendQueue.push(std::move(message)))
+                    return self->disconnect();
+                if (!self->writing && !self->sendQueue.empty())
+                    self->do_write();
+            });
+        }
+
+        // Called by the heartbeat tick: one ping in flight at a time, the payload carries the send time
+        void ping()
+        {
+            asio::post(wsStream.get_executor(), [self = shared_from_this()] {
+                if (self->closed || self->pingPending)
+                    return;
+                self->pingPending = true;
+                ++self->heartbeat.pings;
+
+                const std::string sentAt = std::to_string(Clock::now().time_since_epoch().count());
+                self->wsStream.async_ping(websocket::ping_data { sentAt.data(), sentAt.size() },
+                                          [self](const beast::error_code& errorCode) {
+                    if (errorCode)
+                        self->pingPending = false;
+                });
+            });
+        }
+
+        // Called by the heartbeat to reap a dead connection
+        void close()
+        {
+            asio::post(wsStream.get_executor(), [self = shared_from_this()] {
+                if (!self->closed)
+                    self->disconnect();
+            });
+        }
+
+        [[nodiscard]]
+        Clock::time_point lastActivity() const noexcept {
+            return Clock::time_point { Clock::duration { lastSeen.load(std::memory_order::relaxed) } };
+        }
+
+        // Unknown until the first pong
+        [[nodiscard]]
+        std::optional<Clock::duration> rtt() const noexcept
+        {
+            const Clock::rep value = smoothedRtt.load(std::memory_order::relaxed);
+            return value < 0 ? std::nullopt : std::optional { Clock::duration { value } };
+        }
+
+        [[nodiscard]]
+        bool slow() const noexcept
+        {
+            const std::optional<Clock::duration> estimate = rtt();
+            return estimate && *estimate > options.heartbeat.slowRtt;
+        }
+
         // Start the asynchronous operation
         void on_run()
         {
@@ -257,8 +1028,14 @@ namespace SSL_Asynch_Server
             // the websocket stream has its own timeout system.
             beast::get_lowest_layer(wsStream).expires_never();
 
-            // Set suggested timeout settings for the websocket
-            wsStream.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+            // The heartbeat pings and reaps the sessions: the stream only keeps its handshake timeout
+            websocket::stream_base::timeout timeout = websocket::stream_base::timeout::suggested(beast::role_type::server);
+            timeout.idle_timeout = websocket::stream_base::none();
+            timeout.keep_alive_pings = false;
+            wsStream.set_option(timeout);
+
+            // Accept permessage-deflate when the client offers it
+            wsStream.set_option(Deflate::makeOption(options.deflate, beast::role_type::server));
 
             // Set a decorator to change the Server of the handshake
             wsStream.set_option(websocket::stream_base::decorator([](websocket::response_type& res){
@@ -273,15 +1050,49 @@ namespace SSL_Asynch_Server
         {
             if (errorCode)
                 return fail(errorCode, "accept");
+
+            // Invoked on the strand while a read is pending, which keeps the session alive
+            wsStream.control_callback([this](websocket::frame_type kind, beast::string_view payload) {
+                on_control(kind, payload);
+            });
+            heartbeat.add(shared_from_this());
+
             // Read a message
             do_read();
         }
 
+        void touch() noexcept {
+            lastSeen.store(Clock::now().time_since_epoch().count(), std::memory_order::relaxed);
+        }
+
+        void on_control(websocket::frame_type kind,
+                        beast::string_view payload)
+        {
+            touch();
+            if (websocket::frame_type::pong != kind || !pingPending)
+                return;
+
+            Clock::rep sentAt = 0;
+            if (std::from_chars(payload.data(), payload.data() + payload.size(), sentAt).ec != std::errc {})
+                return;
+            pingPending = false;
+            ++heartbeat.pongs;
+
+            // Smoothed like TCP's SRTT: rtt = 7/8 rtt + 1/8 sample
+            const Clock::rep sample = Clock::now().time_since_epoch().count() - sentAt;
+            const Clock::rep previous = smoothedRtt.load(std::memory_order::relaxed);
+            smoothedRtt.store(previous < 0 ? sample : previous + (sample - previous) / 8, std::memory_order::relaxed);
+            heartbeat.rtt.record(Clock::duration { sample });
+        }
+
         void do_read()
         {   // Read a message into our buffer
             wsStream.async_read(buffer, beast::bind_front_handler(&Session::on_read, shared_from_this()));
         }
 
+        // Commands: "subscribe:<topic>", "unsubscribe:<topic>", "publish:<topic>:<payload>", "file:<name>",
+        // "stats" and "rtt".
+        // Anything else is echoed.
         void on_read(const beast::error_code& errorCode,
                      std::size_t bytes_transferred)
         {
@@ -291,44 +1102,445 @@ namespace SSL_Asynch_Server
                 return;
 
             if (errorCode)
-                fail(errorCode, "read");
+                return fail(errorCode, "read");
 
-            // Echo the message
-            wsStream.text(wsStream.got_text());
+            touch();
+            const std::string_view request { static_cast<const char*>(buffer.data().data()), buffer.size() };
+            if (request.starts_with("subscribe:"))
+            {
+                const std::string_view topic = request.substr(std::string_view("subscribe:").size());
+                if (topics.emplace(topic).second)
+                    registry.join(shard, topic, shared_from_this());
+            }
+            else if (request.starts_with("unsubscribe:"))
+            {
+                const std::string_view topic = request.substr(std::string_view("unsubscribe:").size());
+                if (const auto iter = topics.find(std::string(topic)); topics.end() != iter) {
+                    topics.erase(iter);
+                    registry.leave(shard, topic, this);
+                }
+            }
+            else if (request.starts_with("publish:"))
+            {
+                const std::string_view command = request.substr(std::string_view("publish:").size());
+                const size_t separator = command.find(':');
+                if (std::string_view::npos != separator)
+                    registry.publish(shard, command.substr(0, separator), command.substr(separator + 1));
+            }
+            else if (request.starts_with("file:"))
+            {
+                start_file(request.substr(std::string_view("file:").size()));
+            }
+            else if ("stats" == request)
+            {
+                send(Outbound { std::make_shared<const std::string>(queueMetrics.toJson(sendQueue.size())) });
+            }
+            else if ("rtt" == request)
+            {
+                const std::optional<Clock::duration> estimate = rtt();
+                const int64_t micros = estimate ? std::chrono::duration_cast<std::chrono::microseconds>(*estimate).count() : -1;
+                send(Outbound { std::make_shared<const std::string>(
+                    std::format(R"({{"rttUs":{},"heartbeat":{}}})", micros, heartbeat.toJson())) });
+            }
+            else
+            {
+                // Echo the message
+                echoPending = true;
+                if (!writing)
+                    do_write();
+                return;
+            }
+
+            // Clear the buffer
+            buffer.consume(buffer.size());
+            // Writes are driven by the send queue, so keep reading
+            do_read();
+        }
+
+        void reply(std::string text) {
+            send(Outbound { std::make_shared<const std::string>(std::move(text)) });
+        }
+
+        void start_file(std::string_view name)
+        {
+            if (transfer)
+                return reply("error: a file is already streaming");
+            if (name.empty() || name.contains('/') || name.contains(".."))
+                return reply("error: bad file name");
+
+            const std::string path = std::format("{}/{}", options.files.root, name);
+            beast::error_code errorCode;
+#if defined(BOOST_ASIO_HAS_FILE)
+            File file { wsStream.get_executor() };
+            file.open(path, File::read_only, errorCode);
+#else
+            File file;
+            file.open(path.c_str(), beast::file_mode::scan, errorCode);
+#endif
+            if (errorCode)
+                return reply("error: " + errorCode.message());
+
+            transfer = std::make_unique<FileTransfer>(chunkPool, std::move(file), name);
+            for (size_t i = 0; i < options.files.chunksPerTransfer; ++i)
+            {
+                std::unique_ptr<char[]> data = chunkPool.acquire();
+                if (!data)
+                    break;
+                transfer->free.push_back(transfer->chunks.size());
+                transfer->chunks.push_back(FileTransfer::Chunk { std::move(data) });
+            }
+            if (transfer->chunks.empty()) {
+                transfer.reset();
+                return reply("error: too many files streaming, try again later");
+            }
+
+            // One frame per chunk
+            wsStream.auto_fragment(false);
+            read_file();
+        }
+
+        // Reads ahead while a chunk is free: a slow socket leaves no chunk free and pauses the disk
+        void read_file()
+        {
+            if (transfer->reading || transfer->eof || transfer->free.empty())
+                return;
+
+            const size_t index = transfer->free.front();
+            transfer->free.pop_front();
+            transfer->reading = true;
+            const asio::mutable_buffer chunk { transfer->chunks[index].data.get(), chunkPool.chunkSize };
+#if defined(BOOST_ASIO_HAS_FILE)
+            asio::async_read(transfer->file, chunk,
+                             beast::bind_front_handler(&Session::on_file_read, shared_from_this(), index));
+#else
+            beast::error_code errorCode;
+            const size_t bytesRead = transfer->file.read(chunk.data(), chunk.size(), errorCode);
+            if (!errorCode && bytesRead < chunk.size())
+                errorCode = asio::error::eof;
+            asio::post(wsStream.get_executor(), beast::bind_front_handler(&Session::on_file_read, shared_from_this(),
+                                                                          index, errorCode, bytesRead));
+#endif
+        }
+
+        void on_file_read(size_t index,
+                          const beast::error_code& errorCode,
+                          std::size_t bytes_transferred)
+        {
+            transfer->reading = false;
+            if (errorCode && asio::error::eof != errorCode) {
+                // The message can't be completed: the client sees the connection drop rather than a truncated file
+                fail(errorCode, "file read");
+                return disconnect();
+            }
+
+            transfer->chunks[index].size = bytes_transferred;
+            (bytes_transferred > 0 ? transfer->filled : transfer->free).push_back(index);
+            transfer->eof = asio::error::eof == errorCode;
+
+            read_file();
+            if (!writing && !closed)
+                do_write();
+        }
 
-            std::string responseData = std::string {"["}
-                .append(beast::buffers_to_string(buffer.data())).append("]");
-            auto response = boost::asio::buffer(responseData, responseData.length());
+        void write_fragment()
+        {
+            if (transfer->filled.empty() && !transfer->eof) {
+                // The disk is behind: the next completed read resumes writing
+                writing = false;
+                return;
+            }
+
+            // A file that ends on a chunk boundary is finished by an empty frame
+            const bool last = transfer->eof && transfer->filled.size() <= 1;
+            size_t index = noChunk;
+            asio::const_buffer payload;
+            if (!transfer->filled.empty())
+            {
+                index = transfer->filled.front();
+                transfer->filled.pop_front();
+                payload = asio::buffer(transfer->chunks[index].data.get(), transfer->chunks[index].size);
+            }
+
+            wsStream.binary(true);
+            wsStream.async_write_some(last, payload,
+                beast::bind_front_handler(&Session::on_fragment_written, shared_from_this(), index, last));
+        }
+
+        void on_fragment_written(size_t index,
+                                 bool last,
+                                 const beast::error_code& errorCode,
+                                 std::size_t bytes_transferred)
+        {
+            boost::ignore_unused(bytes_transferred);
+            if (errorCode) {
+                // `writing` stays set: nothing more is written to a broken stream
+                return fail(errorCode, "write");
+            }
+
+            writing = false;
+            // Pongs are only seen while a read is pending, and reads wait behind the transfer when an echo is
+            // queued: a peer that keeps taking whole chunks is alive all the same
+            touch();
+            if (noChunk != index) {
+                transfer->sent += transfer->chunks[index].size;
+                transfer->free.push_back(index);
+            }
+
+            if (last)
+                finish_file();
+            else
+                read_file();
+
+            if ((transfer || echoPending || !sendQueue.empty()) && !closed)
+                do_write();
+        }
 
-            wsStream.async_write(response,
+        void finish_file()
+        {
+            const auto elapsed = std::chrono::duration<double>(Clock::now() - transfer->started);
+            std::println("file '{}': {} bytes in {:.3f} s, {:.1f} MB/s", transfer->name, transfer->sent,
+                         elapsed.count(), double(transfer->sent) / (1024.0 * 1024.0) / std::max(elapsed.count(), 1e-9));
+            wsStream.auto_fragment(true);
+            transfer.reset();
+        }
+
+        void do_write()
+        {
+            writing = true;
+            // Nothing may be written between the frames of the file message
+            if (transfer)
+                return write_fragment();
+
+            if (echoPending)
+            {
+                // Gather write: the frame payload references the static brackets and the read buffer, nothing is copied
+                echoPending = false;
+                echoing = true;
+                wsStream.text(wsStream.got_text());
+                return wsStream.async_write(
+                    beast::buffers_cat(asio::buffer(echoPrefix), buffer.data(), asio::buffer(echoSuffix)),
+                    beast::bind_front_handler(&Session::on_write, shared_from_this()));
+            }
+
+            Outbound message = sendQueue.pop();
+            wsStream.text(message.text);
+
+            if (options.queue.coalesceBytes > 0 && message.text)
+            {
+                size_t joined = 0;
+                while (!sendQueue.empty() && sendQueue.front().text)
+                {
+                    const size_t size = (0 == joined ? message.payload->size() : batch.size())
+                                        + 1 + sendQueue.front().payload->size();
+                    if (size > options.queue.coalesceBytes)
+                        break;
+                    if (0 == joined)
+                        batch.assign(*message.payload);
+                    batch.append(1, '\n').append(*sendQueue.pop().payload);
+                    ++joined;
+                }
+                if (joined > 0)
+                {
+                    queueMetrics.coalesced += joined;
+                    return wsStream.async_write(asio::buffer(batch),
+                                                beast::bind_front_handler(&Session::on_write, shared_from_this()));
+                }
+            }
+
+            // Stays alive (shared with the other recipients) until the write completes
+            current = std::move(message.payload);
+            wsStream.async_write(asio::buffer(*current),
                                  beast::bind_front_handler(&Session::on_write, shared_from_this()));
-            // wsStream.async_write(buffer.data(),, beast::bind_front_handler(&Session::on_write, shared_from_this()));
         }
 
         void on_write(const beast::error_code& errorCode,
                       std::size_t bytes_transferred)
         {
             boost::ignore_unused(bytes_transferred);
+            writing = false;
+            current.reset();
+            batch.clear();
             if (errorCode)
                 return fail(errorCode, "write");
-            // Clear the buffer
-            buffer.consume(buffer.size());
-            // Do another read
-            do_read();
+
+            if (echoing)
+            {
+                echoing = false;
+                buffer.consume(buffer.size());
+                do_read();
+            }
+            else
+            {
+                ++queueMetrics.written;
+            }
+
+            if ((transfer || echoPending || !sendQueue.empty()) && !closed)
+                do_write();
+        }
+
+        // Slow consumer under OverflowPolicy::Disconnect: pending operations fail and release the session
+        void disconnect()
+        {
+            closed = true;
+            beast::get_lowest_layer(wsStream).close();
         }
     };
 
+    void Registry::join(Shard& shard,
+                        std::string_view topic,
+                        const std::shared_ptr<Session>& session)
+    {
+        auto iter = shard.rooms.find(topic);
+        if (shard.rooms.end() == iter)
+            iter = shard.rooms.emplace(std::string(topic), Shard::Members {}).first;
+        std::erase_if(iter->second, [](const std::weak_ptr<Session>& member) { return member.expired(); });
+        iter->second.push_back(session);
+    }
+
+    void Registry::leave(Shard& shard,
+                         std::string_view topic,
+                         const Session* session)
+    {
+        const auto iter = shard.rooms.find(topic);
+        if (shard.rooms.end() == iter)
+            return;
+
+        std::erase_if(iter->second, [session](const std::weak_ptr<Session>& member) {
+            const std::shared_ptr<Session> alive = member.lock();
+            return !alive || alive.get() == session;
+        });
+        if (iter->second.empty())
+            shard.rooms.erase(iter);
+    }
+
+    void Registry::publish(Shard& shard,
+                           std::string_view topic,
+                           std::string_view payload)
+    {
+        // One allocation and one copy of the payload, whatever the number of shards and recipients
+        Shard::Delivery delivery { std::make_shared<const std::string>(topic),
+                                   std::make_shared<const std::string>(payload) };
+        for (const std::unique_ptr<Shard>& other: shards) {
+            if (other.get() != &shard)
+                other->enqueue(delivery);
+        }
+        shard.deliver(delivery);
+    }
+
+    void Registry::Shard::enqueue(Delivery delivery)
+    {
+        inbox.push(std::move(delivery));
+        if (!scheduled.exchange(true))
+            asio::post(strand, [this] { drain(); });
+    }
+
+    void Registry::Shard::drain()
+    {
+        for (size_t handled = 0; handled < drainBatch; ++handled)
+        {
+            std::optional<Delivery> delivery = inbox.pop();
+            if (!delivery)
+            {
+                // A producer that saw `scheduled` set before this store relies on the check below
+                scheduled.store(false);
+                if (inbox.empty() || scheduled.exchange(true))
+                    return;
+                continue;
+            }
+            deliver(*delivery);
+        }
+        // Still busy: let the sessions of the shard run before the next batch
+        asio::post(strand, [this] { drain(); });
+    }
+
+    void Registry::Shard::deliver(const Delivery& delivery)
+    {
+        const auto iter = rooms.find(*delivery.topic);
+        if (rooms.end() == iter)
+            return;
+
+        std::vector<std::shared_ptr<Session>> slow;
+        std::erase_if(iter->second, [&](const std::weak_ptr<Session>& member) {
+            const std::shared_ptr<Session> session = member.lock();
+            if (!session)
+                return true;
+            if (session->slow())
+                slow.push_back(session);
+            else
+                session->send(Outbound { delivery.payload, delivery.topic, true });
+            return false;
+        });
+        // Slow consumers (by heartbeat RTT) are queued last, so they don't delay the fast ones
+        for (const std::shared_ptr<Session>& session: slow)
+            session->send(Outbound { delivery.payload, delivery.topic, true });
+        if (iter->second.empty())
+            rooms.erase(iter);
+    }
+
+    void Heartbeat::schedule()
+    {
+        timer.expires_after(options.interval);
+        timer.async_wait([this](const beast::error_code& errorCode) {
+            if (!errorCode)
+                tick();
+        });
+    }
+
+    void Heartbeat::tick()
+    {
+        std::vector<std::shared_ptr<Session>> alive;
+        {
+            std::lock_guard lock { mutex };
+            alive.reserve(sessions.size());
+            std::erase_if(sessions, [&alive](const std::weak_ptr<Session>& session) {
+                if (std::shared_ptr<Session> active = session.lock()) {
+                    alive.push_back(std::move(active));
+                    return false;
+                }
+                return true;
+            });
+        }
+
+        // Sessions dead beyond the batch are still dead on the next tick
+        const Clock::time_point deadline = Clock::now() - options.timeout;
+        size_t closed = 0;
+        for (const std::shared_ptr<Session>& session: alive)
+        {
+            if (session->lastActivity() >= deadline)
+                session->ping();
+            else if (closed < options.reapBatch) {
+                session->close();
+                ++closed;
+            }
+        }
+
+        live = alive.size();
+        reaped += closed;
+        schedule();
+    }
+
     class Listener : public std::enable_shared_from_this<Listener>
     {
         asio::io_context& ioContext;
         ssl::context& context;
+        Registry& registry;
+        Heartbeat& heartbeat;
+        ChunkPool& chunkPool;
+        const SessionOptions& sessionOptions;
+        QueueMetrics& queueMetrics;
         tcp::acceptor acceptor_;
 
     public:
         Listener(asio::io_context& ioc,
                  ssl::context& ctx,
+                 Registry& registry,
+                 Heartbeat& heartbeat,
+                 ChunkPool& chunkPool,
+                 const SessionOptions& sessionOptions,
+                 QueueMetrics& queueMetrics,
                  const tcp::endpoint& endpoint)
-            : ioContext(ioc), context(ctx), acceptor_(asio::make_strand(ioc))
+            : ioContext(ioc), context(ctx), registry(registry), heartbeat(heartbeat), chunkPool(chunkPool),
+              sessionOptions(sessionOptions), queueMetrics(queueMetrics), acceptor_(asio::make_strand(ioc))
         {
             beast::error_code errorCode;
 
@@ -371,19 +1583,22 @@ namespace SSL_Asynch_Server
 
         void do_accept()
         {
-            // The new connection gets its own strand
-            acceptor_.async_accept(asio::make_strand(ioContext),
-                beast::bind_front_handler(&Listener::on_accept,shared_from_this()));
+            // The new connection runs on the strand of its shard
+            Registry::Shard& shard = registry.assign();
+            acceptor_.async_accept(shard.executor(),
+                beast::bind_front_handler(&Listener::on_accept, shared_from_this(), std::ref(shard)));
         }
 
-        void on_accept(const beast::error_code& errorCode,
+        void on_accept(Registry::Shard& shard,
+                       const beast::error_code& errorCode,
                        tcp::socket socket)
         {
             if (errorCode) {
                 fail(errorCode, "accept");
             } else {
                 // Create the session and run it
-                std::make_shared<Session>(std::move(socket), context)->run();
+                std::make_shared<Session>(std::move(socket), context, registry, shard, heartbeat, chunkPool,
+                                          sessionOptions, queueMetrics)->run();
             }
 
             // Accept another connection
@@ -399,13 +1614,26 @@ namespace SSL_Asynch_Server
 
         try
         {
+            // Outlive the io_context: sessions destroyed with it update the metrics and return their file chunks
+            const SessionOptions sessionOptions {
+                .queue = { .capacity = 256, .policy = OverflowPolicy::ConflateByKey },
+                // Feeds are repetitive JSON: keep the context, but with a smaller window than zlib's default
+                .deflate = { .windowBits = 12, .memLevel = 5, .minSize = 128 }
+            };
+            QueueMetrics queueMetrics;
+            ChunkPool chunkPool { sessionOptions.files.chunkSize, sessionOptions.files.poolChunks };
             asio::io_context ioCtx { threads };
             ssl::context ctx { ssl::context::tlsv13 };
+            Heartbeat heartbeat { ioCtx, sessionOptions.heartbeat };
+            // More shards than threads, so a busy shard doesn't hold a thread's worth of sessions
+            Registry registry { ioCtx, threads * 4u };
 
             load_server_certificate(ctx);
 
             const asio::ip::address address = asio::ip::make_address(host);
-            std::make_shared<Listener>(ioCtx, ctx, tcp::endpoint { address, port })->run();
+            std::make_shared<Listener>(ioCtx, ctx, registry, heartbeat, chunkPool, sessionOptions, queueMetrics,
+                                       tcp::endpoint { address, port })->run();
+            heartbeat.start();
 
             std::vector<std::thread> workers;
             workers.reserve(threads - 1);
@@ -421,9 +1649,363 @@ namespace SSL_Asynch_Server
 }
 
 
+namespace SSL_Asynch_Server::EchoBenchmark
+{
+    using TestStream = websocket::stream<beast::test::stream>;
+
+    // Framing cost of the echo reply: the former concatenation into a string vs the buffers_cat gather.
+    // Both are written as server frames to an in-memory peer, the write path of a session minus the socket.
+    // Copied bytes count what goes into intermediate strings before the write, not the framing itself.
+    void run()
+    {
+        using Clock = std::chrono::steady_clock;
+
+        asio::io_context ioCtx;
+        TestStream server { ioCtx }, client { ioCtx };
+        server.next_layer().connect(client.next_layer());
+        server.async_accept([](const beast::error_code& errorCode) {
+            if (errorCode)
+                fail(errorCode, "accept");
+        });
+        client.async_handshake("localhost", "/", [](const beast::error_code& errorCode) {
+            if (errorCode)
+                fail(errorCode, "handshake");
+        });
+        ioCtx.run();
+
+        std::println("{:>8} {:>18} {:>18} {:>18} {:>18}", "payload", "concat ns/msg", "concat copied/msg",
+                     "gather ns/msg", "gather copied/msg");
+        for (const size_t size: { 16uz, 256uz, 4096uz, 65536uz })
+        {
+            const size_t iterations = std::max(10'000uz, (512uz << 20) / size);
+
+            beast::flat_buffer buffer;
+            const asio::mutable_buffer block = buffer.prepare(size);
+            std::memset(block.data(), 'x', size);
+            buffer.commit(size);
+
+            size_t concatCopied = 0, gatherCopied = 0;
+            const auto perMessage = [&](const auto& write) {
+                const Clock::time_point start = Clock::now();
+                for (size_t i = 0; i < iterations; ++i) {
+                    write();
+                    // The peer never reads: the frames are dropped so that its buffer does not grow
+                    client.next_layer().clear();
+                }
+                const Clock::duration elapsed = Clock::now() - start;
+                return double(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / double(iterations);
+            };
+
+            const double concat = perMessage([&] {
+                const std::string payload = beast::buffers_to_string(buffer.data());
+                const std::string response = std::string { echoPrefix }.append(payload).append(echoSuffix);
+                concatCopied += payload.size() + response.size();
+                server.write(asio::buffer(response));
+            });
+            const double gather = perMessage([&] {
+                const auto reply = beast::buffers_cat(asio::buffer(echoPrefix), buffer.data(), asio::buffer(echoSuffix));
+                // Every byte of the reply is referenced where it already is: prefix, read buffer, suffix
+                gatherCopied += beast::buffer_bytes(reply) - echoPrefix.size() - buffer.size() - echoSuffix.size();
+                server.write(reply);
+            });
+            std::println("{:>8} {:>18.1f} {:>18} {:>18.1f} {:>18}", size, concat, concatCopied / iterations,
+                         gather, gatherCopied / iterations);
+        }
+    }
+}
+
+namespace DeflateBenchmark
+{
+    using TestStream = websocket::stream<beast::test::stream>;
+
+    // Thread CPU time: what compression costs the sender, whatever else the machine is doing
+    std::chrono::nanoseconds cpuTime() noexcept
+    {
+        timespec time {};
+        ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+        return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+    }
+
+    // Market data feed: quotes, with an order book snapshot every 20 messages
+    std::vector<std::string> makePayloads(size_t count)
+    {
+        constexpr std::array<std::string_view, 8> symbols { "AAPL", "MSFT", "GOOG", "AMZN", "NVDA", "TSLA", "META", "NFLX" };
+        std::mt19937 random { 42 };
+        std::uniform_real_distribution<double> price { 100.0, 500.0 };
+        std::uniform_int_distribution<uint32_t> lots { 1, 50 };
+
+        const auto levels = [&](std::string& output) {
+            for (int level = 0; level < 20; ++level)
+                output += std::format(R"({}{{"price":{:.2f},"size":{}}})", 0 == level ? "" : ",",
+                                      price(random), lots(random) * 100);
+        };
+
+        std::vector<std::string> payloads;
+        payloads.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const std::string_view symbol = symbols[i % symbols.size()];
+            if (0 == i % 20)
+            {
+                std::string book = std::format(R"({{"type":"book","symbol":"{}","seq":{},"bids":[)", symbol, i);
+                levels(book);
+                book += R"(],"asks":[)";
+                levels(book);
+                book += "]}";
+                payloads.push_back(std::move(book));
+            }
+            else
+            {
+                const double bid = price(random);
+                payloads.push_back(std::format(R"({{"type":"quote","symbol":"{}","seq":{},"bid":{:.2f},"ask":{:.2f},)"
+                                               R"("bidSize":{},"askSize":{},"exchange":"NASDAQ",)"
+                                               R"("timestamp":"2026-10-19T12:{:02}:{:02}.{:03}Z"}})",
+                                               symbol, i, bid, bid + 0.02, lots(random) * 100, lots(random) * 100,
+                                               (i / 60'000) % 60, (i / 1'000) % 60, i % 1'000));
+            }
+        }
+        return payloads;
+    }
+
+    struct Result
+    {
+        uint64_t payloadBytes { 0 };
+        uint64_t wireBytes { 0 };
+        std::chrono::nanoseconds deflateCpu { 0 };
+        std::chrono::nanoseconds inflateCpu { 0 };
+    };
+
+    // Server to client over an in-memory stream pair: the wire bytes are exactly the frames written
+    Result measure(const Deflate::Options& options,
+                   const std::vector<std::string>& payloads)
+    {
+        asio::io_context ioCtx;
+        TestStream server { ioCtx }, client { ioCtx };
+        server.next_layer().connect(client.next_layer());
+        server.set_option(Deflate::makeOption(options, beast::role_type::server));
+        client.set_option(Deflate::makeOption(options, beast::role_type::client));
+
+        server.async_accept([](const beast::error_code& errorCode) {
+            if (errorCode)
+                fail(errorCode, "accept");
+        });
+        client.async_handshake("localhost", "/", [](const beast::error_code& errorCode) {
+            if (errorCode)
+                fail(errorCode, "handshake");
+        });
+        ioCtx.run();
+
+        Result result;
+        beast::flat_buffer buffer;
+        const size_t handshakeBytes = client.next_layer().nread_bytes();
+        for (const std::string& payload: payloads)
+        {
+            std::chrono::nanoseconds start = cpuTime();
+            server.write(asio::buffer(payload));
+            result.deflateCpu += cpuTime() - start;
+
+            start = cpuTime();
+            client.read(buffer);
+            result.inflateCpu += cpuTime() - start;
+
+            buffer.consume(buffer.size());
+            result.payloadBytes += payload.size();
+        }
+        result.wireBytes = client.next_layer().nread_bytes() - handshakeBytes;
+        return result;
+    }
+
+    void run()
+    {
+        constexpr size_t messages { 50'000 };
+        const std::vector<std::string> payloads = makePayloads(messages);
+
+        const std::array<std::pair<std::string_view, Deflate::Options>, 5> configurations {{
+            { "uncompressed", { .enabled = false } },
+            { "15 bits, mem 8", { .windowBits = 15, .memLevel = 8 } },
+            { "12 bits, mem 5", { .windowBits = 12, .memLevel = 5 } },
+            { "no context takeover", { .serverNoContextTakeover = true, .clientNoContextTakeover = true } },
+            { "9 bits, mem 1, level 1", { .windowBits = 9, .memLevel = 1, .compressionLevel = 1 } },
+        }};
+
+        std::println("{:<24} {:>12} {:>8} {:>16} {:>16}", "configuration", "wire B/msg", "saved",
+                     "deflate us/msg", "inflate us/msg");
+        for (const auto& [name, options]: configurations)
+        {
+            const Result result = measure(options, payloads);
+            const auto perMessage = [](std::chrono::nanoseconds cpu) {
+                return double(cpu.count()) / 1'000.0 / double(messages);
+            };
+            std::println("{:<24} {:>12.1f} {:>7.1f}% {:>16.2f} {:>16.2f}", name,
+                         double(result.wireBytes) / double(messages),
+                         100.0 * (1.0 - double(result.wireBytes) / double(result.payloadBytes)),
+                         perMessage(result.deflateCpu), perMessage(result.inflateCpu));
+        }
+    }
+}
+
+// Varint fields of the benchmark messages, as JSON numbers
+namespace BinaryCodec
+{
+    template <class T>
+    void tag_invoke(const boost::json::value_from_tag&,
+                    boost::json::value& json,
+                    const Varint<T>& number) {
+        json = number.value;
+    }
+
+    template <class T>
+    Varint<T> tag_invoke(const boost::json::value_to_tag<Varint<T>>&,
+                         const boost::json::value& json) {
+        return Varint<T> { boost::json::value_to<T>(json) };
+    }
+}
+
+namespace CodecBenchmark
+{
+    namespace json = boost::json;
+    using BinaryCodec::Varint;
+
+    enum class Side : uint8_t
+    {
+        Bid,
+        Ask
+    };
+    BOOST_DESCRIBE_ENUM(Side, Bid, Ask)
+
+    struct Level
+    {
+        double price {};
+        uint32_t size {};
+    };
+    BOOST_DESCRIBE_STRUCT(Level, (), (price, size))
+
+    struct BookUpdate
+    {
+        Varint<uint64_t> sequence;
+        uint64_t timestamp {};
+        std::string symbol;
+        Side side { Side::Bid };
+        std::vector<Level> levels;
+    };
+    BOOST_DESCRIBE_STRUCT(BookUpdate, (), (sequence, timestamp, symbol, side, levels))
+
+    std::vector<BookUpdate> makeUpdates(size_t count)
+    {
+        constexpr std::array<std::string_view, 8> symbols { "AAPL", "MSFT", "GOOG", "AMZN", "NVDA", "TSLA", "META", "NFLX" };
+        std::mt19937 random { 42 };
+        std::uniform_real_distribution<double> price { 100.0, 500.0 };
+        std::uniform_int_distribution<uint32_t> lots { 1, 50 };
+        std::uniform_int_distribution<size_t> depth { 1, 10 };
+
+        std::vector<BookUpdate> updates(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            BookUpdate& update = updates[i];
+            update.sequence = i;
+            update.timestamp = 1'792'400'000'000'000'000ULL + i * 1'000;
+            update.symbol = symbols[i % symbols.size()];
+            update.side = 0 == i % 2 ? Side::Bid : Side::Ask;
+            update.levels.resize(depth(random));
+            for (Level& level: update.levels)
+                level = Level { price(random), lots(random) * 100 };
+        }
+        return updates;
+    }
+
+    // Messages as they are received: one flat_buffer each
+    std::vector<beast::flat_buffer> receive(const std::vector<std::string>& messages)
+    {
+        std::vector<beast::flat_buffer> buffers(messages.size());
+        for (size_t i = 0; i < messages.size(); ++i)
+            buffers[i].commit(asio::buffer_copy(buffers[i].prepare(messages[i].size()), asio::buffer(messages[i])));
+        return buffers;
+    }
+
+    struct Result
+    {
+        size_t bytes { 0 };
+        std::chrono::nanoseconds encodeCpu {};
+        std::chrono::nanoseconds decodeCpu {};
+        uint64_t checksum { 0 };
+    };
+
+    template <class Encode, class Decode>
+    Result measure(const std::vector<BookUpdate>& updates,
+                   Encode encode,
+                   Decode decode)
+    {
+        Result result;
+        std::vector<std::string> messages(updates.size());
+
+        const std::chrono::nanoseconds encodeStart = DeflateBenchmark::cpuTime();
+        for (size_t i = 0; i < updates.size(); ++i)
+            messages[i] = encode(updates[i]);
+        result.encodeCpu = DeflateBenchmark::cpuTime() - encodeStart;
+
+        for (const std::string& message: messages)
+            result.bytes += message.size();
+
+        const std::vector<beast::flat_buffer> buffers = receive(messages);
+        const std::chrono::nanoseconds decodeStart = DeflateBenchmark::cpuTime();
+        for (const beast::flat_buffer& buffer: buffers)
+        {
+            const BookUpdate update = decode(buffer);
+            // Keeps the decoding from being optimized away
+            result.checksum += update.sequence + update.levels.size();
+        }
+        result.decodeCpu = DeflateBenchmark::cpuTime() - decodeStart;
+        return result;
+    }
+
+    void run()
+    {
+        constexpr size_t messages { 200'000 };
+        const std::vector<BookUpdate> updates = makeUpdates(messages);
+
+        const Result binary = measure(updates,
+            [](const BookUpdate& update) {
+                return BinaryCodec::encode(update);
+            },
+            [](const beast::flat_buffer& buffer) {
+                return BinaryCodec::decode<BookUpdate>(buffer).value();
+            });
+
+        // The usual text path: described struct -> json::value -> string, and back through the DOM
+        const Result text = measure(updates,
+            [](const BookUpdate& update) {
+                return json::serialize(json::value_from(update));
+            },
+            [](const beast::flat_buffer& buffer) {
+                const std::string_view message { static_cast<const char*>(buffer.data().data()), buffer.size() };
+                return json::value_to<BookUpdate>(json::parse(message));
+            });
+
+        if (binary.checksum != text.checksum)
+            std::println("checksum mismatch: {} vs {}", binary.checksum, text.checksum);
+
+        std::println("{:<8} {:>10} {:>14} {:>14}", "codec", "B/msg", "encode ns/msg", "decode ns/msg");
+        for (const auto& [name, result]: { std::pair { "binary", binary }, std::pair { "json", text } })
+        {
+            std::println("{:<8} {:>10.1f} {:>14.1f} {:>14.1f}", name, double(result.bytes) / messages,
+                         double(result.encodeCpu.count()) / messages, double(result.decodeCpu.count()) / messages);
+        }
+    }
+}
+
+// websocat -k wss://localhost:6789
+//   subscribe:prices
+//   publish:prices:{"symbol":"ABC","price":10.5}
+//   stats
+//   rtt
+//   file:<name>
 void WebSocketServers::TestAll()
 {
     // SimpleServer::runServer();
     // SSLServer::runServer();
+    // CoroutineServer::runServer(true);
     SSL_Asynch_Server::runServer();
+    // SSL_Asynch_Server::EchoBenchmark::run();
+    // DeflateBenchmark::run();
+    // CodecBenchmark::run();
 }
\ No newline at end of file